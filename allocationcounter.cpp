@@ -0,0 +1,121 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstddef>
+
+#if defined(ALLOCATIONCOUNTER_ENABLED) && defined(__GLIBC__)
+#include <cerrno>
+#define ALLOCATIONCOUNTER_GLIBC
+#elif defined(ALLOCATIONCOUNTER_ENABLED) && defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#define ALLOCATIONCOUNTER_CRTDBG
+#endif
+
+namespace {
+std::atomic<quint64> s_allocations{0};
+
+inline void countAllocation()
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+#if defined(ALLOCATIONCOUNTER_GLIBC)
+// Qt 容器直接调用 malloc，只替换 operator new 统计不到，因此替换 malloc 系列函数本身
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+void *__libc_pvalloc(size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0) {
+        return EINVAL;
+    }
+    countAllocation();
+    void *memory = __libc_memalign(alignment, size);
+    if (!memory) {
+        return ENOMEM;
+    }
+    *pointer = memory;
+    return 0;
+}
+
+void *valloc(size_t size)
+{
+    countAllocation();
+    return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size)
+{
+    countAllocation();
+    return __libc_pvalloc(size);
+}
+
+void free(void *pointer)
+{
+    __libc_free(pointer);
+}
+}
+#elif defined(ALLOCATIONCOUNTER_CRTDBG)
+namespace {
+int allocationHook(int type, void *, size_t, int, long, const unsigned char *, int)
+{
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) {
+        countAllocation();
+    }
+    return TRUE;
+}
+
+const int s_hookInstalled = (_CrtSetAllocHook(allocationHook), 0);
+}
+#endif
+
+bool AllocationCounter::isSupported()
+{
+#if defined(ALLOCATIONCOUNTER_GLIBC) || defined(ALLOCATIONCOUNTER_CRTDBG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+quint64 AllocationCounter::count()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,16 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// 进程内堆分配次数，供基准测试比较不同实现的分配开销。
+// 只在以 -DTRANSLATE_ALLOCATION_COUNTER=ON 配置的构建中统计：glibc 上替换 malloc 系列函数并转发给 __libc_*，
+// MSVC 调试运行库上使用分配钩子。默认构建不替换分配器，isSupported 返回 false。
+class AllocationCounter
+{
+public:
+    static bool isSupported();
+    static quint64 count();
+};
+
+#endif // ALLOCATIONCOUNTER_H
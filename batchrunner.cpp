@@ -0,0 +1,294 @@
+#include "batchrunner.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+BatchRunner::BatchRunner(QObject *parent)
+    : QObject{parent}
+{
+    connect(&m_translator, &Translator::sig_chunkFinished, this, &BatchRunner::chunkFinished);
+    connect(&m_translator, &Translator::sig_jobFinished, this, &BatchRunner::jobFinished);
+}
+
+bool BatchRunner::isBatchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BatchRunner::parseArguments(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch translation: reads records and writes translations in input order.");
+    parser.addHelpOption();
+    QCommandLineOption batchOption("batch", "Run in headless batch mode.");
+    QCommandLineOption inputOption({"i", "input"}, "Input file, - for stdin.", "file", "-");
+    QCommandLineOption outputOption({"o", "output"}, "Output file, - for stdout.", "file", "-");
+    QCommandLineOption formatOption("format", "Record format: text (one per line) or jsonl.", "format");
+    QCommandLineOption fieldOption("field", "JSONL field to translate.", "name", "text");
+    QCommandLineOption concurrencyOption({"j", "concurrency"}, "Records translated concurrently.", "n", "8");
+    QCommandLineOption providerOption("provider", "Primary provider: v1 (volcengine) or v2 (tencent).", "name", "v1");
+    QCommandLineOption chunkSizeOption("chunk-size", "Maximum characters per request.", "n", "2000");
+    QCommandLineOption v1UrlOption("v1-url", "Base URL for the volcengine provider.", "url");
+    QCommandLineOption v2UrlOption("v2-url", "Base URL for the tencent provider.", "url");
+    QCommandLineOption noHedgingOption("no-hedging", "Never send a chunk to the second provider.");
+    QCommandLineOption sessionCacheOption("session-cache", "File for persisted TLS session tickets.", "file");
+    QCommandLineOption rateOption("rate", "Requests per second per provider, 0 for unlimited.", "n", "0");
+    QCommandLineOption noStreamingOption("no-streaming-decoder", "Parse complete responses with QJsonDocument instead.");
+    QCommandLineOption benchOption("bench", "Translate n synthetic unique records instead of reading input.", "n");
+    QCommandLineOption http1Option("http1", "Use HTTP/1.1 only instead of negotiating HTTP/2.");
+    QCommandLineOption h2cOption("h2c", "Use HTTP/2 with prior knowledge on plain http:// provider URLs.");
+    QCommandLineOption streamsOption("streams", "Concurrent HTTP/2 streams per host.", "n", "100");
+    QCommandLineOption noCompressionOption("no-compression", "Ask providers for uncompressed responses.");
+    QCommandLineOption compressRequestsOption("compress-requests", "Send request bodies gzip-compressed.");
+    QCommandLineOption traceOption("trace", "Write per-stage timings of the last records as a Chrome trace.", "file");
+    QCommandLineOption metricsOption("metrics", "Write per-stage latency histograms in Prometheus text format.", "file");
+    parser.addOptions({batchOption, inputOption, outputOption, formatOption, fieldOption,
+                       concurrencyOption, providerOption, chunkSizeOption,
+                       v1UrlOption, v2UrlOption, noHedgingOption, sessionCacheOption, rateOption, noStreamingOption, benchOption,
+                       http1Option, h2cOption, streamsOption, noCompressionOption, compressRequestsOption,
+                       traceOption, metricsOption});
+    parser.process(arguments);
+
+    m_benchRecords = parser.value(benchOption).toLongLong();
+    m_traceFile = parser.value(traceOption);
+    m_metricsFile = parser.value(metricsOption);
+    const QString input = parser.value(inputOption);
+    // 压测模式生成合成记录，不读取输入
+    if (m_benchRecords <= 0) {
+        if (input == "-") {
+            m_inputFile.open(stdin, QIODevice::ReadOnly);
+        } else {
+            m_inputFile.setFileName(input);
+            m_inputFile.open(QIODevice::ReadOnly);
+        }
+        if (!m_inputFile.isOpen()) {
+            qCritical() << "Failed to open input:" << input << m_inputFile.errorString();
+            return false;
+        }
+    }
+
+    const QString output = parser.value(outputOption);
+    if (output == "-") {
+        m_outputFile.open(stdout, QIODevice::WriteOnly);
+    } else {
+        m_outputFile.setFileName(output);
+        m_outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!m_outputFile.isOpen()) {
+        qCritical() << "Failed to open output:" << output << m_outputFile.errorString();
+        return false;
+    }
+
+    m_input.setDevice(&m_inputFile);
+    m_output.setDevice(&m_outputFile);
+
+    // 未指定格式时按扩展名判断
+    const QString format = parser.isSet(formatOption) ? parser.value(formatOption)
+                                                      : (input.endsWith(".jsonl") ? "jsonl" : "text");
+    if (format != "text" && format != "jsonl") {
+        qCritical() << "Unknown format:" << format;
+        return false;
+    }
+    m_jsonl = format == "jsonl";
+    m_field = parser.value(fieldOption);
+    m_concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+
+    m_translator.setApiVersion(parser.value(providerOption) == "v2" ? API_VERSION::V2 : API_VERSION::V1);
+    m_translator.setChunkSize(parser.value(chunkSizeOption).toInt());
+    m_translator.setBaseUrl(API_VERSION::V1, parser.value(v1UrlOption));
+    m_translator.setBaseUrl(API_VERSION::V2, parser.value(v2UrlOption));
+    if (parser.isSet(sessionCacheOption)) {
+        m_translator.setSessionCacheFile(parser.value(sessionCacheOption));
+    }
+    if (parser.isSet(noHedgingOption)) {
+        m_translator.setHedging(false);
+        m_translator.setAutoSelect(false);
+    }
+    m_translator.setStreamingDecoder(!parser.isSet(noStreamingOption));
+    m_translator.setHttp2Enabled(!parser.isSet(http1Option));
+    m_translator.setHttp2Cleartext(parser.isSet(h2cOption));
+    m_translator.setMaxStreamsPerHost(parser.value(streamsOption).toInt());
+    m_translator.setResponseCompression(!parser.isSet(noCompressionOption));
+    m_translator.setRequestCompression(API_VERSION::V1, parser.isSet(compressRequestsOption));
+    m_translator.setRequestCompression(API_VERSION::V2, parser.isSet(compressRequestsOption));
+    // 批量任务全部按低优先级排队，并遵守服务商的速率限制
+    m_translator.setPriority(HttpManager::Bulk);
+    m_translator.setRateLimit(API_VERSION::V1, parser.value(rateOption).toDouble());
+    m_translator.setRateLimit(API_VERSION::V2, parser.value(rateOption).toDouble());
+    return true;
+}
+
+void BatchRunner::start()
+{
+    m_timer.start();
+    fill();
+}
+
+bool BatchRunner::readRecord(Record *record)
+{
+    if (m_benchRecords > 0) {
+        // 每条文本都不同，避免命中缓存
+        if (m_nextIndex >= m_benchRecords) {
+            return false;
+        }
+        record->text = QString("Benchmark record %1: the quick brown fox jumps over the lazy dog.").arg(m_nextIndex);
+        return true;
+    }
+
+    QString line;
+    while (m_input.readLineInto(&line)) {
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+
+        if (!m_jsonl) {
+            record->text = line.trimmed();
+            return true;
+        }
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8(), &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            qWarning() << "Skipping invalid JSONL record:" << parseError.errorString();
+            continue;
+        }
+        record->object = doc.object();
+        record->text = record->object.value(m_field).toString().trimmed();
+        return true;
+    }
+    return false;
+}
+
+void BatchRunner::fill()
+{
+    // 缓存命中时 start 会同步完成任务并重入 fill，由外层循环继续读取
+    if (m_filling) {
+        return;
+    }
+    m_filling = true;
+
+    while (!m_inputDone && m_running.size() < m_concurrency) {
+        Record record;
+        if (!readRecord(&record)) {
+            m_inputDone = true;
+            break;
+        }
+        record.index = m_nextIndex++;
+        m_chars += record.text.size();
+
+        record.traceId = m_translator.tracer().begin();
+        const quint64 jobId = m_translator.createJob(record.text, record.traceId);
+        record.chunks = QStringList(m_translator.chunkCount(jobId), QString());
+        record.elapsed.start();
+        m_running.insert(jobId, record);
+        m_translator.start(jobId);
+    }
+    m_filling = false;
+
+    if (m_inputDone && m_running.isEmpty() && m_ready.isEmpty()) {
+        finish();
+    }
+}
+
+void BatchRunner::chunkFinished(quint64 jobId, int index, QString text)
+{
+    auto it = m_running.find(jobId);
+    if (it != m_running.end() && index >= 0 && index < it->chunks.size()) {
+        it->chunks[index] = text;
+    }
+}
+
+void BatchRunner::jobFinished(quint64 jobId, bool ok)
+{
+    Record record = m_running.take(jobId);
+    m_latencies.append(record.elapsed.elapsed());
+    m_translator.tracer().finish(record.traceId);
+    if (!ok) {
+        ++m_failed;
+    }
+
+    const QString translation = record.chunks.join(QString()).trimmed();
+    if (m_jsonl) {
+        record.object["translation"] = translation;
+        m_ready.insert(record.index, QString::fromUtf8(QJsonDocument(record.object).toJson(QJsonDocument::Compact)));
+    } else {
+        // 文本模式一行一条记录
+        m_ready.insert(record.index, QString(translation).replace('\n', ' '));
+    }
+
+    writeReady();
+    fill();
+}
+
+void BatchRunner::writeReady()
+{
+    // 按输入顺序写出，前面的记录未完成时先缓存
+    while (!m_ready.isEmpty() && m_ready.firstKey() == m_nextWrite) {
+        m_output << m_ready.take(m_nextWrite) << '\n';
+        ++m_nextWrite;
+    }
+    m_output.flush();
+}
+
+void BatchRunner::finish()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+
+    m_output.flush();
+
+    const double seconds = qMax<qint64>(1, m_timer.elapsed()) / 1000.0;
+    std::sort(m_latencies.begin(), m_latencies.end());
+    auto percentile = [this](double p) -> qint64 {
+        if (m_latencies.isEmpty()) {
+            return 0;
+        }
+        return m_latencies.at(qBound(0, int(m_latencies.size() * p), m_latencies.size() - 1));
+    };
+
+    QTextStream err(stderr);
+    err << QString("records: %1 (failed %2)  chars: %3  time: %4 s\n")
+               .arg(m_nextIndex).arg(m_failed).arg(m_chars).arg(seconds, 0, 'f', 2);
+    err << QString("throughput: %1 records/s  %2 chars/s\n")
+               .arg(m_nextIndex / seconds, 0, 'f', 1).arg(m_chars / seconds, 0, 'f', 0);
+    err << QString("latency: p50 %1 ms  p90 %2 ms  p99 %3 ms  p999 %4 ms  max %5 ms\n")
+               .arg(percentile(0.5)).arg(percentile(0.9)).arg(percentile(0.99)).arg(percentile(0.999))
+               .arg(m_latencies.isEmpty() ? 0 : m_latencies.last());
+    err << "payload: " << m_translator.payloadSummary() << '\n';
+    err << "reuse: " << m_translator.reuseSummary() << '\n';
+    err << "encode: " << m_translator.encodeSummary() << '\n';
+    err << "decode: " << m_translator.decodeSummary() << '\n';
+    for (const QString &line : m_translator.connectionSummary()) {
+        err << "connection: " << line << '\n';
+    }
+    for (const QString &line : m_translator.queueSummary()) {
+        err << "queue: " << line << '\n';
+    }
+    for (const QString &line : m_translator.transferSummary()) {
+        err << "transfer: " << line << '\n';
+    }
+    for (const QString &line : m_translator.tracer().summary()) {
+        err << "stage: " << line << '\n';
+    }
+    if (!m_traceFile.isEmpty() && !m_translator.tracer().writeChromeTrace(m_traceFile)) {
+        err << "Failed to write trace: " << m_traceFile << '\n';
+    }
+    if (!m_metricsFile.isEmpty() && !m_translator.tracer().writeMetrics(m_metricsFile)) {
+        err << "Failed to write metrics: " << m_metricsFile << '\n';
+    }
+    err.flush();
+
+    QCoreApplication::exit(m_failed > 0 ? 2 : 0);
+}
@@ -0,0 +1,72 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QTextStream>
+#include "translator.h"
+
+// 命令行批量翻译：逐条读取输入记录，以有限并发通过 Translator 翻译，
+// 按输入顺序写出结果，结束时在 stderr 输出吞吐量和延迟分位数。
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchRunner(QObject *parent = nullptr);
+
+    static bool isBatchMode(int argc, char *argv[]);
+    bool parseArguments(const QStringList &arguments);
+
+public slots:
+    void start();
+
+private slots:
+    void chunkFinished(quint64 jobId, int index, QString text);
+    void jobFinished(quint64 jobId, bool ok);
+
+private:
+    struct Record {
+        qint64 index{0};
+        QString text;
+        QJsonObject object;  // JSONL 模式下的原始记录
+        QStringList chunks;
+        QElapsedTimer elapsed;
+        quint64 traceId{0};
+    };
+
+    void fill();
+    bool readRecord(Record *record);
+    void writeReady();
+    void finish();
+
+    Translator m_translator;
+    QFile m_inputFile;
+    QFile m_outputFile;
+    QTextStream m_input;
+    QTextStream m_output;
+    bool m_jsonl{false};
+    QString m_field{"text"};
+    int m_concurrency{8};
+    qint64 m_benchRecords{0};  // 大于 0 时生成合成记录代替读取输入
+    QString m_traceFile;       // 结束时写出的 Chrome trace
+    QString m_metricsFile;     // 结束时写出的各阶段耗时直方图
+
+    bool m_inputDone{false};
+    bool m_filling{false};
+    bool m_finished{false};
+    qint64 m_nextIndex{0};       // 下一条读取的记录序号
+    qint64 m_nextWrite{0};       // 下一条要写出的记录序号
+    QHash<quint64, Record> m_running;  // 任务 ID -> 记录
+    QMap<qint64, QString> m_ready;     // 已完成但尚未按序写出的结果
+
+    QElapsedTimer m_timer;
+    qint64 m_chars{0};
+    qint64 m_failed{0};
+    QList<qint64> m_latencies;
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,206 @@
+#include "bodycodec.h"
+
+#ifdef HTTPMANAGER_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HTTPMANAGER_BROTLI
+#include <brotli/decode.h>
+#endif
+
+namespace {
+const int kOutputBlock = 16 * 1024;
+}
+
+struct BodyCodec::State
+{
+#ifdef HTTPMANAGER_ZLIB
+    z_stream zlib{};
+    bool zlibReady{false};
+#endif
+#ifdef HTTPMANAGER_BROTLI
+    BrotliDecoderState *brotli{nullptr};
+#endif
+
+    ~State()
+    {
+#ifdef HTTPMANAGER_ZLIB
+        if (zlibReady) {
+            inflateEnd(&zlib);
+        }
+#endif
+#ifdef HTTPMANAGER_BROTLI
+        if (brotli) {
+            BrotliDecoderDestroyInstance(brotli);
+        }
+#endif
+    }
+};
+
+BodyCodec::BodyCodec(Encoding encoding, QObject *parent)
+    : QObject{parent}
+    , m_encoding(encoding)
+    , m_state(new State)
+{
+#ifdef HTTPMANAGER_ZLIB
+    // gzip 和带 zlib 头的 deflate 由 inflate 自动识别，裸 deflate 在收到数据后再决定
+    if (encoding == Gzip) {
+        m_state->zlibReady = inflateInit2(&m_state->zlib, 15 + 32) == Z_OK;
+        m_error = !m_state->zlibReady;
+        return;
+    }
+    if (encoding == Deflate) {
+        return;
+    }
+#endif
+#ifdef HTTPMANAGER_BROTLI
+    if (encoding == Brotli) {
+        m_state->brotli = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        m_error = !m_state->brotli;
+        return;
+    }
+#endif
+    m_error = encoding != Identity;
+}
+
+BodyCodec::~BodyCodec() = default;
+
+bool BodyCodec::isAvailable()
+{
+#ifdef HTTPMANAGER_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+BodyCodec::Encoding BodyCodec::parseEncoding(const QByteArray &contentEncoding)
+{
+    const QByteArray encoding = contentEncoding.trimmed().toLower();
+    if (encoding.isEmpty() || encoding == "identity") {
+        return Identity;
+    }
+    if (encoding == "gzip" || encoding == "x-gzip") {
+        return Gzip;
+    }
+    if (encoding == "deflate") {
+        return Deflate;
+    }
+    if (encoding == "br") {
+        return Brotli;
+    }
+    return Unsupported;
+}
+
+QByteArray BodyCodec::acceptEncoding()
+{
+#ifdef HTTPMANAGER_BROTLI
+    return "gzip, deflate, br";
+#else
+    return "gzip, deflate";
+#endif
+}
+
+QByteArray BodyCodec::decode(const QByteArray &data)
+{
+    if (m_error || data.isEmpty()) {
+        return QByteArray();
+    }
+    if (m_encoding == Identity) {
+        return data;
+    }
+
+    QByteArray output;
+#ifdef HTTPMANAGER_ZLIB
+    if (m_encoding == Gzip || m_encoding == Deflate) {
+        QByteArray input = data;
+        if (!m_state->zlibReady) {
+            // 规范要求 deflate 带 zlib 头，但不少服务器发送裸 deflate 数据
+            m_head += data;
+            if (m_head.size() < 2) {
+                return QByteArray();
+            }
+            const uchar cmf = uchar(m_head.at(0));
+            const uchar flg = uchar(m_head.at(1));
+            const bool zlibHeader = (cmf & 0x0f) == 8 && (cmf * 256 + flg) % 31 == 0;
+            m_state->zlibReady = inflateInit2(&m_state->zlib, zlibHeader ? 15 : -15) == Z_OK;
+            if (!m_state->zlibReady) {
+                m_error = true;
+                return QByteArray();
+            }
+            input = m_head;
+            m_head.clear();
+        }
+
+        z_stream &stream = m_state->zlib;
+        stream.next_in = reinterpret_cast<Bytef *>(input.data());
+        stream.avail_in = uInt(input.size());
+        while (stream.avail_in > 0) {
+            const qsizetype offset = output.size();
+            output.resize(offset + kOutputBlock);
+            stream.next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+            stream.avail_out = kOutputBlock;
+            const int result = inflate(&stream, Z_NO_FLUSH);
+            output.resize(offset + kOutputBlock - stream.avail_out);
+            if (result == Z_STREAM_END) {
+                break;
+            }
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                m_error = true;
+                break;
+            }
+            if (result == Z_BUF_ERROR && stream.avail_out != 0) {
+                break;
+            }
+        }
+        return output;
+    }
+#endif
+#ifdef HTTPMANAGER_BROTLI
+    if (m_encoding == Brotli) {
+        const uint8_t *next = reinterpret_cast<const uint8_t *>(data.constData());
+        size_t available = size_t(data.size());
+        forever {
+            const qsizetype offset = output.size();
+            output.resize(offset + kOutputBlock);
+            uint8_t *out = reinterpret_cast<uint8_t *>(output.data() + offset);
+            size_t space = kOutputBlock;
+            const BrotliDecoderResult result = BrotliDecoderDecompressStream(m_state->brotli, &available, &next,
+                                                                             &space, &out, nullptr);
+            output.resize(offset + kOutputBlock - qsizetype(space));
+            if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+                continue;
+            }
+            if (result == BROTLI_DECODER_RESULT_ERROR) {
+                m_error = true;
+            }
+            break;
+        }
+        return output;
+    }
+#endif
+    return output;
+}
+
+QByteArray BodyCodec::gzip(const QByteArray &data, int level)
+{
+#ifdef HTTPMANAGER_ZLIB
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return QByteArray();
+    }
+    QByteArray output;
+    output.resize(qsizetype(deflateBound(&stream, uLong(data.size()))));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = uInt(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.avail_out = uInt(output.size());
+    const int result = deflate(&stream, Z_FINISH);
+    output.resize(qsizetype(stream.total_out));
+    deflateEnd(&stream);
+    return result == Z_STREAM_END ? output : QByteArray();
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(level)
+    return QByteArray();
+#endif
+}
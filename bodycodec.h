@@ -0,0 +1,46 @@
+#ifndef BODYCODEC_H
+#define BODYCODEC_H
+
+#include <QByteArray>
+#include <QObject>
+#include <memory>
+
+// HTTP 消息体的内容编码：按 Content-Encoding 流式解压 gzip、deflate（编译时找到 brotli 时还有 br），
+// 以及用 gzip 压缩请求体。没有 zlib（未定义 HTTPMANAGER_ZLIB）时不可用，由 Qt 透明解压响应。
+// 解码器作为 QNetworkReply 的子对象，随回复一起销毁
+class BodyCodec : public QObject
+{
+    Q_OBJECT
+public:
+    enum Encoding {
+        Identity,
+        Gzip,
+        Deflate,
+        Brotli,
+        Unsupported
+    };
+
+    explicit BodyCodec(Encoding encoding, QObject *parent = nullptr);
+    ~BodyCodec() override;
+
+    static bool isAvailable();
+    static Encoding parseEncoding(const QByteArray &contentEncoding);
+    // 请求头 Accept-Encoding 的值，只列出本程序能解压的编码
+    static QByteArray acceptEncoding();
+    static QByteArray gzip(const QByteArray &data, int level = 6);
+
+    Encoding encoding() const { return m_encoding; }
+    // 解压一段到达的数据，返回其中已能还原的部分；数据损坏或编码不支持时置 hasError
+    QByteArray decode(const QByteArray &data);
+    bool hasError() const { return m_error; }
+
+private:
+    struct State;
+
+    Encoding m_encoding;
+    std::unique_ptr<State> m_state;
+    QByteArray m_head;  // deflate 需要前两个字节判断是否带 zlib 头
+    bool m_error{false};
+};
+
+#endif // BODYCODEC_H
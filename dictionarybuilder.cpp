@@ -0,0 +1,357 @@
+#include "dictionarybuilder.h"
+#include "offlinedictionary.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace {
+// ECDICT exchange 字段中表示词形变化的类型：过去式、过去分词、现在分词、三单、复数、比较级、最高级
+const QString kInflectionTypes = "pdi3srt";
+
+// 进程当前的常驻内存，用于估计词典映射后实际占用的物理内存
+qint64 residentBytes()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.WorkingSetSize);
+    }
+    return 0;
+#else
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * 4096 : 0;
+#endif
+}
+
+QList<QStringList> parseCsv(const QString &data)
+{
+    QList<QStringList> rows;
+    QStringList row;
+    QString field;
+    bool quoted = false;
+    for (qsizetype i = 0; i < data.size(); ++i) {
+        const QChar ch = data.at(i);
+        if (quoted) {
+            if (ch == '"' && i + 1 < data.size() && data.at(i + 1) == '"') {
+                field.append('"');
+                ++i;
+            } else if (ch == '"') {
+                quoted = false;
+            } else {
+                field.append(ch);
+            }
+        } else if (ch == '"') {
+            quoted = true;
+        } else if (ch == ',') {
+            row.append(field);
+            field.clear();
+        } else if (ch == '\n') {
+            row.append(field);
+            field.clear();
+            rows.append(row);
+            row.clear();
+        } else if (ch != '\r') {
+            field.append(ch);
+        }
+    }
+    if (!field.isEmpty() || !row.isEmpty()) {
+        row.append(field);
+        rows.append(row);
+    }
+    return rows;
+}
+
+QString unescapeNewlines(QString text)
+{
+    return text.replace("\\n", "\n").trimmed();
+}
+}
+
+bool DictionaryBuilder::isToolMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--build-dictionary") == 0 || std::strcmp(argv[i], "--dict-bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int DictionaryBuilder::run(const QStringList &arguments)
+{
+    return arguments.contains("--dict-bench") ? benchmark(arguments) : build(arguments);
+}
+
+void DictionaryBuilder::addEntry(const QString &word, const QString &text)
+{
+    const QString key = OfflineDictionary::normalize(word);
+    if (key.isEmpty() || text.isEmpty()) {
+        return;
+    }
+    QString &value = m_entries[key];
+    if (value.isEmpty()) {
+        value = text;
+    } else if (!value.contains(text)) {
+        value += "; " + text;  // 同一个词出现在多行或多个词表中
+    }
+}
+
+bool DictionaryBuilder::addFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Failed to open word list:" << path << file.errorString();
+        return false;
+    }
+    const QByteArray head = file.peek(64);
+    file.close();
+
+    if (path.endsWith(".csv", Qt::CaseInsensitive)) {
+        return readEcdict(path);
+    }
+    if (path.endsWith(".u8", Qt::CaseInsensitive) || head.startsWith('#')) {
+        return readCedict(path);
+    }
+    return readTsv(path);
+}
+
+bool DictionaryBuilder::readTsv(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    QString line;
+    while (in.readLineInto(&line)) {
+        const qsizetype tab = line.indexOf('\t');
+        if (tab > 0) {
+            addEntry(line.left(tab), unescapeNewlines(line.mid(tab + 1)));
+        }
+    }
+    return true;
+}
+
+bool DictionaryBuilder::readEcdict(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    const QList<QStringList> rows = parseCsv(QString::fromUtf8(file.readAll()));
+    if (rows.isEmpty()) {
+        return false;
+    }
+
+    const QStringList header = rows.first();
+    const int wordColumn = header.indexOf("word");
+    const int phoneticColumn = header.indexOf("phonetic");
+    const int translationColumn = header.indexOf("translation");
+    const int exchangeColumn = header.indexOf("exchange");
+    if (wordColumn < 0 || translationColumn < 0) {
+        qWarning() << "Missing word/translation columns:" << path;
+        return false;
+    }
+
+    // 先收集原形，词形变化只在没有独立词条时才指向原形
+    QList<QPair<QString, QString>> inflections;
+    for (qsizetype i = 1; i < rows.size(); ++i) {
+        const QStringList &row = rows.at(i);
+        if (row.size() <= translationColumn) {
+            continue;
+        }
+        QString text = unescapeNewlines(row.at(translationColumn));
+        if (text.isEmpty()) {
+            continue;
+        }
+        if (phoneticColumn >= 0 && phoneticColumn < row.size() && !row.at(phoneticColumn).isEmpty()) {
+            text = "[" + row.at(phoneticColumn) + "]\n" + text;
+        }
+        const QString word = row.at(wordColumn);
+        addEntry(word, text);
+
+        if (exchangeColumn < 0 || exchangeColumn >= row.size()) {
+            continue;
+        }
+        for (const QString &item : row.at(exchangeColumn).split('/', Qt::SkipEmptyParts)) {
+            if (item.size() > 2 && item.at(1) == ':' && kInflectionTypes.contains(item.at(0))) {
+                inflections.append({item.mid(2), "→ " + word + "\n" + text});
+            }
+        }
+    }
+    for (const auto &inflection : std::as_const(inflections)) {
+        if (!m_entries.contains(OfflineDictionary::normalize(inflection.first))) {
+            addEntry(inflection.first, inflection.second);
+        }
+    }
+    return true;
+}
+
+bool DictionaryBuilder::readCedict(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    static const QRegularExpression entry("^(\\S+) (\\S+) \\[([^\\]]*)\\] /(.*)/$");
+    QTextStream in(&file);
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (line.startsWith('#')) {
+            continue;
+        }
+        const QRegularExpressionMatch match = entry.match(line);
+        if (!match.hasMatch()) {
+            continue;
+        }
+        const QString text = "[" + match.captured(3) + "]\n" + match.captured(4).split('/').join("; ");
+        addEntry(match.captured(2), text);
+        if (match.captured(1) != match.captured(2)) {
+            addEntry(match.captured(1), text);
+        }
+    }
+    return true;
+}
+
+bool DictionaryBuilder::write(const QString &path) const
+{
+    return OfflineDictionary::write(m_entries, path);
+}
+
+int DictionaryBuilder::build(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Build the offline dictionary from open bilingual word lists.");
+    parser.addHelpOption();
+    QCommandLineOption buildOption("build-dictionary", "Build a dictionary file from the given word lists.");
+    QCommandLineOption outputOption({"o", "output"}, "Output file.", "file", OfflineDictionary::defaultPath());
+    parser.addOptions({buildOption, outputOption});
+    parser.addPositionalArgument("lists", "ECDICT csv, CC-CEDICT or tab separated word lists.", "lists...");
+    parser.process(arguments);
+
+    QTextStream err(stderr);
+    if (parser.positionalArguments().isEmpty()) {
+        err << "No word lists given\n";
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    DictionaryBuilder builder;
+    for (const QString &path : parser.positionalArguments()) {
+        if (!builder.addFile(path)) {
+            err << "Failed to read " << path << "\n";
+            return 1;
+        }
+    }
+    const QString output = parser.value(outputOption);
+    if (!builder.write(output)) {
+        return 1;
+    }
+    const qint64 size = QFileInfo(output).size();
+    err << QString("dictionary: %1 entries, %2 bytes (%3 bytes/entry) in %4 ms -> %5\n")
+               .arg(builder.count()).arg(size)
+               .arg(builder.count() > 0 ? double(size) / builder.count() : 0.0, 0, 'f', 1)
+               .arg(timer.elapsed()).arg(output);
+    return 0;
+}
+
+int DictionaryBuilder::benchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offline dictionary lookup latency and memory benchmark.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("dict-bench", "Dictionary file to measure.", "file", OfflineDictionary::defaultPath());
+    QCommandLineOption queriesOption("queries", "Number of hit and miss lookups.", "n", "100000");
+    parser.addOptions({benchOption, queriesOption});
+    parser.process(arguments);
+
+    QTextStream err(stderr);
+    const int queries = qMax(1, parser.value(queriesOption).toInt());
+    const qint64 residentBefore = residentBytes();
+
+    QElapsedTimer timer;
+    timer.start();
+    OfflineDictionary dictionary;
+    if (!dictionary.open(parser.value(benchOption))) {
+        err << "Failed to open " << parser.value(benchOption) << "\n";
+        return 1;
+    }
+    const qint64 openNsecs = timer.nsecsElapsed();
+    if (dictionary.count() == 0) {
+        err << "Dictionary is empty\n";
+        return 1;
+    }
+
+    // 命中查询从字典树随机抽取，未命中查询是同样长度的随机字母串
+    QRandomGenerator random(20240601);
+    QStringList hitQueries;
+    QStringList missQueries;
+    for (int i = 0; i < queries; ++i) {
+        // 长词组不会被当作单词查询，抽样时跳过
+        QString key = dictionary.sampleKey(&random);
+        for (int attempt = 0; attempt < 100 && !OfflineDictionary::isShortQuery(key); ++attempt) {
+            key = dictionary.sampleKey(&random);
+        }
+        hitQueries.append(key);
+        QString miss;
+        for (qsizetype j = 0; j < qMax<qsizetype>(3, key.size()); ++j) {
+            miss.append(QChar('a' + random.bounded(26)));
+        }
+        missQueries.append(miss + "qx");
+    }
+
+    auto measure = [&dictionary](const QStringList &list, int *found) {
+        QList<qint64> latencies;
+        latencies.reserve(list.size());
+        QElapsedTimer lookupTimer;
+        QString result;
+        for (const QString &query : list) {
+            lookupTimer.start();
+            const bool hit = dictionary.lookup(query, &result);
+            latencies.append(lookupTimer.nsecsElapsed());
+            *found += hit ? 1 : 0;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        return latencies;
+    };
+    auto line = [](const QList<qint64> &latencies) {
+        auto percentile = [&latencies](double p) {
+            return latencies.at(qBound(0, int(latencies.size() * p), int(latencies.size()) - 1));
+        };
+        return QString("p50 %1 ns  p99 %2 ns  max %3 ns").arg(percentile(0.5)).arg(percentile(0.99)).arg(latencies.last());
+    };
+
+    int hits = 0;
+    int misses = 0;
+    const QList<qint64> hitLatencies = measure(hitQueries, &hits);
+    const QList<qint64> missLatencies = measure(missQueries, &misses);
+    const qint64 residentAfter = residentBytes();
+
+    err << QString("open: %1 us\n").arg(openNsecs / 1000.0, 0, 'f', 1);
+    err << QString("hit lookups: %1/%2  %3\n").arg(hits).arg(queries).arg(line(hitLatencies));
+    err << QString("miss lookups: %1/%2 found  %3\n").arg(misses).arg(queries).arg(line(missLatencies));
+    err << QString("file: %1 entries, %2 bytes (%3 bytes/entry)\n")
+               .arg(dictionary.count()).arg(dictionary.fileSize())
+               .arg(double(dictionary.fileSize()) / dictionary.count(), 0, 'f', 1);
+    err << QString("resident: +%1 KB after lookups\n").arg((residentAfter - residentBefore) / 1024);
+    err.flush();
+    return hits == queries ? 0 : 2;
+}
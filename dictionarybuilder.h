@@ -0,0 +1,37 @@
+#ifndef DICTIONARYBUILDER_H
+#define DICTIONARYBUILDER_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// 离线词典的命令行工具：
+//   --build-dictionary -o dictionary.dat 词表...   从开放词表生成 OfflineDictionary 文件
+//   --dict-bench dictionary.dat                     测量打开耗时、查询延迟和内存占用
+// 支持的词表格式按扩展名和首行判断：
+//   *.csv        ECDICT（word,phonetic,definition,translation,...,exchange 列），含词形变化
+//   *.u8 / 以 # 开头的 CC-CEDICT 文本（繁体 简体 [拼音] /释义/.../）
+//   其他         每行 "词<Tab>释义"，释义中的 \n 表示换行
+class DictionaryBuilder
+{
+public:
+    static bool isToolMode(int argc, char *argv[]);
+    static int run(const QStringList &arguments);
+
+    bool addFile(const QString &path);
+    bool write(const QString &path) const;
+    int count() const { return int(m_entries.size()); }
+
+private:
+    void addEntry(const QString &word, const QString &text);
+    bool readTsv(const QString &path);
+    bool readEcdict(const QString &path);
+    bool readCedict(const QString &path);
+
+    static int build(const QStringList &arguments);
+    static int benchmark(const QStringList &arguments);
+
+    QMap<QString, QString> m_entries;
+};
+
+#endif // DICTIONARYBUILDER_H
@@ -0,0 +1,166 @@
+#include "hotkeymonitor.h"
+#include "latencytracer.h"
+
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const qint64 kDoublePressInterval = 500 * 1000 * 1000;  // 纳秒
+}
+
+HotkeyDetector::Result HotkeyDetector::feed(const KeyEvent &event)
+{
+    switch (event.key) {
+    case KeyEvent::Control:
+        if (!event.down) {
+            m_ctrlPress = false;
+            return None;
+        }
+        if (!m_ctrlPress) {
+            m_ctrlPress = true;
+            return CtrlPressed;
+        }
+        return None;
+
+    case KeyEvent::C:
+        if (event.down && m_ctrlPress) {
+            const bool hit = m_lastCopyTime >= 0 && event.time - m_lastCopyTime <= kDoublePressInterval;
+            m_lastCopyTime = event.time;
+            return hit ? Hotkey : None;
+        }
+        return None;
+
+    case KeyEvent::Other:
+        break;
+    }
+    return None;
+}
+
+HotkeyMonitor::HotkeyMonitor(KeyEventSource *source, QObject *parent)
+    : QThread{parent}
+    , m_source(source)
+{
+}
+
+HotkeyMonitor::~HotkeyMonitor()
+{
+    stop();
+}
+
+void HotkeyMonitor::stop()
+{
+    if (isRunning()) {
+        m_source->stop();
+        wait();
+    }
+}
+
+void HotkeyMonitor::run()
+{
+    m_source->run([this](const KeyEvent &event) {
+        handleKey(event);
+    });
+}
+
+void HotkeyMonitor::handleKey(const KeyEvent &event)
+{
+    const qint64 start = LatencyTracer::now();
+    const HotkeyDetector::Result result = m_detector.feed(event);
+    if (result != HotkeyDetector::None) {
+        if (!m_queue.push({result, event.time})) {
+            ++m_dropped;
+        }
+        // 消费者取空队列前会先清除标记，这里只在标记从无到有时投递一次
+        if (!m_notified.exchange(true)) {
+            QMetaObject::invokeMethod(this, &HotkeyMonitor::drain, Qt::QueuedConnection);
+        }
+    }
+
+    const qint64 elapsed = LatencyTracer::now() - start;
+    qint64 previous = m_maxCallbackNsecs.load(std::memory_order_relaxed);
+    while (elapsed > previous && !m_maxCallbackNsecs.compare_exchange_weak(previous, elapsed)) {
+    }
+}
+
+void HotkeyMonitor::drain()
+{
+    m_notified = false;
+    Event event;
+    while (m_queue.pop(&event)) {
+        if (event.type == HotkeyDetector::CtrlPressed) {
+            emit sig_ctrlPressed();
+        } else {
+            emit sig_hotkey(event.time);
+        }
+    }
+}
+
+bool HotkeyMonitor::isBenchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--hotkey-bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int HotkeyMonitor::benchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Hotkey latency benchmark driven by synthetic key events.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("hotkey-bench", "Number of hotkey presses to synthesize.", "n", "1000");
+    QCommandLineOption intervalOption("interval", "Microseconds between key events.", "us", "2000");
+    QCommandLineOption stallOption("stall", "Block the consumer thread for ms every 50 ms to mimic GUI stalls.", "ms", "0");
+    parser.addOptions({benchOption, intervalOption, stallOption});
+    parser.process(arguments);
+
+    const int presses = qMax(2, parser.value(benchOption).toInt());
+    const int interval = qMax(0, parser.value(intervalOption).toInt());
+    const int stall = qMax(0, parser.value(stallOption).toInt());
+
+    // 连按 n 次 C，第一次之后每次都会触发热键
+    HotkeyMonitor monitor(new SyntheticKeyEventSource(SyntheticKeyEventSource::repeatedCopy(presses, interval)));
+    QList<qint64> latencies;
+    connect(&monitor, &HotkeyMonitor::sig_hotkey, &monitor, [&latencies](qint64 time) {
+        latencies.append((LatencyTracer::now() - time) / 1000);
+    });
+
+    QTimer stallTimer;
+    stallTimer.setInterval(50);
+    connect(&stallTimer, &QTimer::timeout, &stallTimer, [stall]() {
+        QThread::msleep(stall);
+    });
+    if (stall > 0) {
+        stallTimer.start();
+    }
+
+    QEventLoop loop;
+    connect(&monitor, &QThread::finished, &loop, &QEventLoop::quit);
+    monitor.start();
+    loop.exec();
+    stallTimer.stop();
+    monitor.drain();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) -> qint64 {
+        if (latencies.isEmpty()) {
+            return 0;
+        }
+        return latencies.at(qBound(0, int(latencies.size() * p), int(latencies.size()) - 1));
+    };
+
+    QTextStream err(stderr);
+    err << QString("hotkeys: %1 (expected %2, dropped %3)\n").arg(latencies.size()).arg(presses - 1).arg(monitor.dropped());
+    err << QString("delivery: p50 %1 us  p99 %2 us  max %3 us\n")
+               .arg(percentile(0.5)).arg(percentile(0.99)).arg(latencies.isEmpty() ? 0 : latencies.last());
+    err << QString("hook callback: max %1 us\n").arg(monitor.maxCallbackNsecs() / 1000.0, 0, 'f', 1);
+    err.flush();
+    return latencies.size() == presses - 1 ? 0 : 2;
+}
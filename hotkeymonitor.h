@@ -0,0 +1,73 @@
+#ifndef HOTKEYMONITOR_H
+#define HOTKEYMONITOR_H
+
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include "keyeventsource.h"
+#include "spscqueue.h"
+
+// 双击 Ctrl+C 的检测逻辑：按住 Ctrl 时两次按下 C 的间隔不超过 500 毫秒即触发
+class HotkeyDetector
+{
+public:
+    enum Result {
+        None,
+        CtrlPressed,  // 首次按下 Ctrl，可用于预热连接
+        Hotkey
+    };
+
+    Result feed(const KeyEvent &event);
+
+private:
+    bool m_ctrlPress{false};
+    qint64 m_lastCopyTime{-1};  // 上次按下 Ctrl+C 的时间（纳秒）
+};
+
+// 在独立线程上运行按键事件来源和热键检测，钩子回调只做检测和入队，不再受 GUI 线程卡顿影响。
+// 检测结果经无锁队列交给创建本对象的线程，在那里以信号发出
+class HotkeyMonitor : public QThread
+{
+    Q_OBJECT
+public:
+    // 接管 source 的所有权
+    explicit HotkeyMonitor(KeyEventSource *source, QObject *parent = nullptr);
+    ~HotkeyMonitor() override;
+
+    void stop();
+
+    // 监听线程上单次事件处理（检测加入队）的最长耗时和因队列满丢弃的事件数
+    qint64 maxCallbackNsecs() const { return m_maxCallbackNsecs; }
+    quint64 dropped() const { return m_dropped; }
+
+    // 用合成按键事件测量从按键到信号送达 GUI 线程的延迟：--hotkey-bench n [--stall ms]
+    static bool isBenchMode(int argc, char *argv[]);
+    static int benchmark(const QStringList &arguments);
+
+signals:
+    void sig_ctrlPressed();
+    void sig_hotkey(qint64 time);  // time 为按键时刻（LatencyTracer::now）
+
+protected:
+    void run() override;
+
+private slots:
+    void drain();
+
+private:
+    struct Event {
+        HotkeyDetector::Result type{HotkeyDetector::None};
+        qint64 time{0};
+    };
+
+    void handleKey(const KeyEvent &event);
+
+    std::unique_ptr<KeyEventSource> m_source;
+    HotkeyDetector m_detector;  // 只在监听线程上访问
+    SpscQueue<Event, 64> m_queue;
+    std::atomic<bool> m_notified{false};  // 已投递 drain 且尚未执行，避免重复投递
+    std::atomic<qint64> m_maxCallbackNsecs{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // HOTKEYMONITOR_H
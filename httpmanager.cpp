@@ -1,9 +1,24 @@
 #include "httpmanager.h"
+#include "bodycodec.h"
 
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
 #include <QJsonDocument>
 #include <QNetworkProxyFactory>
 #include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QSslConfiguration>
 #include <QTimer>
+#include <QtMath>
+
+namespace {
+const qint64 kPreconnectThrottle = 2000;  // 同一主机两次预连接的最小间隔（毫秒）
+const double kHandshakeEwmaAlpha = 0.3;
+const quint32 kSessionFileMagic = 0x544C5331;  // "TLS1"
+const int kDefaultTicketLifetime = 2 * 60 * 60;  // 服务器未给出有效期时按 2 小时
+const int kMinCompressedBody = 1024;  // 小于此大小的请求体压缩收益抵不过开销
+}
 
 HttpManager::HttpManager(QObject *parent)
     : QObject{parent}
@@ -13,11 +28,22 @@ HttpManager::HttpManager(QObject *parent)
     QNetworkProxyFactory::setUseSystemConfiguration(false);
     QNetworkProxy noProxy(QNetworkProxy::NoProxy);
     QNetworkProxy::setApplicationProxy(noProxy);
+
+    m_clock.start();
+    m_keepAliveTimer.setInterval(60 * 1000);
+    connect(&m_keepAliveTimer, &QTimer::timeout, this, &HttpManager::keepAlive);
+
+    // 票据更新后延迟写盘，合并短时间内的多次更新
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(1000);
+    connect(&m_saveTimer, &QTimer::timeout, this, &HttpManager::saveSessionCache);
 }
 
 HttpManager::~HttpManager()
 {
-
+    if (m_saveTimer.isActive()) {
+        saveSessionCache();
+    }
 }
 
 void HttpManager::handleReply()
@@ -34,17 +60,73 @@ void HttpManager::handleReply()
         timer->stop();
         timer->deleteLater();
     }
+    reply->deleteLater();
 
+    // 释放主机的并发名额，在事件循环中调度下一个排队的请求
+    const QString host = reply->property("host").toString();
+    auto queue = m_hosts.find(host);
+    if (queue != m_hosts.end()) {
+        --queue->inFlight;
+        QMetaObject::invokeMethod(this, [this, host]() {
+            schedule(host);
+        }, Qt::QueuedConnection);
+    }
+
+    // 调用方主动取消的请求不再通知
+    const quint64 requestId = reply->property("requestId").toULongLong();
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end() || it->reply != reply) {
+        return;
+    }
+    it->reply = nullptr;
+    recordConnection(reply);
+
+    const bool timedOut = reply->property("timedOut").toBool();
     if (reply->error() != QNetworkReply::NoError) {
         qWarning() << "Network error:" << reply->errorString() 
                   << "for URL:" << reply->url().toString();
-        emit sig_finished(QByteArray());
+
+        // h2 协商或分帧出错时该主机退回 HTTP/1.1，立即重试一次
+        if (!timedOut && isHttp2Failure(reply)) {
+            qWarning() << "HTTP/2 failed for" << host << ", falling back to HTTP/1.1";
+            m_http1Hosts.insert(host);
+            m_http2Hosts.remove(host);
+            m_sslConfigs.remove(host);
+            enqueue(requestId, true);
+            return;
+        }
+
+        // 瞬时错误按指数退避加随机抖动重试，超时不重试以免延长等待
+        if (!timedOut && it->attempt < m_maxRetries && isTransientError(reply)) {
+            const int delay = retryDelay(it->attempt++);
+            qDebug() << "Retrying request" << requestId << "in" << delay << "ms";
+            QTimer::singleShot(delay, this, [this, requestId]() {
+                enqueue(requestId, true);
+            });
+            return;
+        }
+
+        m_requests.erase(it);
+        emit sig_finished(requestId, QByteArray(), timedOut ? TimedOut : Failed);
     } else {
-        QByteArray responseData = reply->readAll();
-        emit sig_finished(responseData);
+        m_requests.erase(it);
+        QByteArray responseData;
+        if (m_streaming) {
+            emitData(requestId, reply);
+        } else {
+            responseData = readBody(reply);
+        }
+
+        // 压缩数据损坏或编码不支持时按失败处理，不交出不完整的内容
+        const BodyCodec *codec = reply->findChild<BodyCodec *>();
+        if (codec && codec->hasError()) {
+            qWarning() << "Failed to decode response body, encoding:" << reply->rawHeader("Content-Encoding")
+                       << "for URL:" << reply->url().toString();
+            emit sig_finished(requestId, QByteArray(), Failed);
+            return;
+        }
+        emit sig_finished(requestId, responseData, Succeeded);
     }
-    
-    reply->deleteLater();
 }
 
 void HttpManager::handleTimeout()
@@ -52,75 +134,662 @@ void HttpManager::handleTimeout()
     QTimer *timer = qobject_cast<QTimer*>(sender());
     if (!timer) return;
 
+    // abort() 会触发 finished，由 handleReply 统一发出失败通知
     QNetworkReply *reply = qobject_cast<QNetworkReply*>(timer->parent());
     if (reply) {
         qWarning() << "Request timeout for URL:" << reply->url().toString();
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    }
+}
+
+void HttpManager::emitData(quint64 requestId, QNetworkReply *reply)
+{
+    const QByteArray data = readBody(reply);
+    if (data.isEmpty()) {
+        return;
+    }
+    const bool first = !reply->property("streamed").toBool();
+    reply->setProperty("streamed", true);
+    emit sig_dataReceived(requestId, data, first);
+}
+
+QByteArray HttpManager::readBody(QNetworkReply *reply)
+{
+    // 解码器在回复的第一段数据到达时按 Content-Encoding 创建，之后逐段解压
+    const QByteArray raw = reply->readAll();
+    TransferStats &stats = m_transferStats[reply->property("host").toString()];
+    BodyCodec *codec = reply->findChild<BodyCodec *>();
+    if (!codec) {
+        codec = new BodyCodec(BodyCodec::parseEncoding(reply->rawHeader("Content-Encoding")), reply);
+        if (codec->encoding() != BodyCodec::Identity) {
+            ++stats.compressedResponses;
+        }
+    }
+
+    const QByteArray data = codec->decode(raw);
+    stats.responseWireBytes += raw.size();
+    stats.responseBytes += data.size();
+    return data;
+}
+
+void HttpManager::setHostRequestCompression(const QString &host, bool enabled)
+{
+    if (enabled) {
+        m_compressRequestHosts.insert(host);
+    } else {
+        m_compressRequestHosts.remove(host);
+    }
+}
+
+QStringList HttpManager::transferSummary() const
+{
+    QStringList lines;
+    for (auto it = m_transferStats.constBegin(); it != m_transferStats.constEnd(); ++it) {
+        lines.append(QString("%1  请求 %2 KB → %3 KB  响应 %4 KB → %5 KB（压缩 %6 次）")
+                         .arg(it.key())
+                         .arg(it->requestBytes / 1024)
+                         .arg(it->requestWireBytes / 1024)
+                         .arg(it->responseBytes / 1024)
+                         .arg(it->responseWireBytes / 1024)
+                         .arg(it->compressedResponses));
+    }
+    return lines;
+}
+
+bool HttpManager::isTransientError(QNetworkReply *reply) const
+{
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ServiceUnavailableError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        break;
+    }
+
+    // 限流和网关错误
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return status == 429 || status == 502 || status == 503 || status == 504;
+}
+
+bool HttpManager::isHttp2Failure(QNetworkReply *reply) const
+{
+    const QNetworkRequest request = reply->request();
+    if (!request.attribute(QNetworkRequest::Http2AllowedAttribute).toBool()
+        && !request.attribute(QNetworkRequest::Http2DirectAttribute).toBool()) {
+        return false;
+    }
+    switch (reply->error()) {
+    case QNetworkReply::ProtocolFailure:
+    case QNetworkReply::ProtocolUnknownError:
+    case QNetworkReply::ProtocolInvalidOperationError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void HttpManager::setHttp2Enabled(bool enabled)
+{
+    m_http2 = enabled;
+    if (!enabled) {
+        m_http2Hosts.clear();
+    }
+    // ALPN 协议列表随之变化，已构建的 TLS 配置作废
+    m_sslConfigs.clear();
+}
+
+int HttpManager::retryDelay(int attempt) const
+{
+    // 200ms、400ms、800ms... 上浮最多 50% 的随机抖动
+    const int base = 200 << qMin(attempt, 5);
+    return base + QRandomGenerator::global()->bounded(base / 2 + 1);
+}
+
+void HttpManager::abort(quint64 requestId)
+{
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) return;
+
+    QNetworkReply *reply = it->reply;
+    if (!reply) {
+        auto queue = m_hosts.find(it->request.url().host());
+        if (queue != m_hosts.end()) {
+            queue->queued[it->priority].removeOne(requestId);
+        }
+    }
+    m_requests.erase(it);
+    if (reply) {
         reply->abort();
-        reply->deleteLater();
     }
+}
+
+void HttpManager::setHostRateLimit(const QString &host, double requestsPerSecond, int burst)
+{
+    HostQueue &queue = m_hosts[host];
+    queue.rate = qMax(0.0, requestsPerSecond);
+    queue.burst = qMax(1, burst);
+    queue.tokens = qMin(queue.tokens, double(queue.burst));
+}
+
+int HttpManager::queueDepth(const QString &host) const
+{
+    auto it = m_hosts.constFind(host);
+    if (it == m_hosts.constEnd()) {
+        return 0;
+    }
+    int depth = 0;
+    for (const QList<quint64> &queued : it->queued) {
+        depth += queued.size();
+    }
+    return depth;
+}
+
+HttpManager::QueueStats HttpManager::queueStats(const QString &host, Priority priority) const
+{
+    auto it = m_hosts.constFind(host);
+    return it == m_hosts.constEnd() ? QueueStats() : it->stats[priority];
+}
+
+QStringList HttpManager::queueSummary() const
+{
+    QStringList lines;
+    for (auto it = m_hosts.constBegin(); it != m_hosts.constEnd(); ++it) {
+        QString line = QString("%1  排队 %2  进行中 %3").arg(it.key()).arg(queueDepth(it.key())).arg(it->inFlight);
+        const char *names[PriorityCount] = {"交互", "批量"};
+        for (int p = 0; p < PriorityCount; ++p) {
+            const QueueStats &stats = it->stats[p];
+            if (stats.dispatched == 0) {
+                continue;
+            }
+            line += QString("  %1 %2 次 平均等待 %3ms 最长 %4ms 最大队列 %5")
+                        .arg(names[p])
+                        .arg(stats.dispatched)
+                        .arg(stats.totalWaitMs / qint64(stats.dispatched))
+                        .arg(stats.maxWaitMs)
+                        .arg(stats.maxDepth);
+        }
+        lines.append(line);
+    }
+    return lines;
+}
 
-    timer->deleteLater();
-    emit sig_finished(QByteArray());
+void HttpManager::enqueue(quint64 requestId, bool front)
+{
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) return;
+
+    const QString host = it->request.url().host();
+    HostQueue &queue = m_hosts[host];
+    QList<quint64> &queued = queue.queued[it->priority];
+    // 重试的请求排在同优先级的最前面
+    if (front) {
+        queued.prepend(requestId);
+    } else {
+        queued.append(requestId);
+    }
+    it->queuedAt = m_clock.elapsed();
+
+    QueueStats &stats = queue.stats[it->priority];
+    stats.maxDepth = qMax(stats.maxDepth, int(queued.size()));
+    schedule(host);
 }
 
-void HttpManager::setupReply(QNetworkReply *reply)
+bool HttpManager::takeToken(HostQueue &queue, int *waitMs)
 {
-    if (!reply) return;
+    if (queue.rate <= 0) {
+        return true;
+    }
+
+    // 按经过的时间补充令牌，最多积累 burst 个
+    const qint64 now = m_clock.elapsed();
+    if (queue.refilledAt < 0) {
+        queue.tokens = queue.burst;
+    } else {
+        queue.tokens = qMin(double(queue.burst), queue.tokens + (now - queue.refilledAt) * queue.rate / 1000.0);
+    }
+    queue.refilledAt = now;
+
+    if (queue.tokens >= 1) {
+        queue.tokens -= 1;
+        return true;
+    }
+    *waitMs = qMax(1, qCeil((1 - queue.tokens) * 1000.0 / queue.rate));
+    return false;
+}
+
+void HttpManager::schedule(const QString &host)
+{
+    auto queueIt = m_hosts.find(host);
+    if (queueIt == m_hosts.end() || queueIt->waiting) {
+        return;
+    }
+
+    // HTTP/1.1 的并发受连接数限制；HTTP/2 的请求作为同一连接上的流并发发出
+    const int maxInFlight = m_http2Hosts.contains(host) ? m_maxStreamsPerHost : m_maxInFlightPerHost;
+    while (queueIt->inFlight < maxInFlight) {
+        int priority = 0;
+        while (priority < PriorityCount && queueIt->queued[priority].isEmpty()) {
+            ++priority;
+        }
+        if (priority == PriorityCount) {
+            return;
+        }
+
+        int waitMs = 0;
+        if (!takeToken(*queueIt, &waitMs)) {
+            // 令牌不足时等到下一个令牌生成再调度
+            queueIt->waiting = true;
+            QTimer::singleShot(waitMs, this, [this, host]() {
+                m_hosts[host].waiting = false;
+                schedule(host);
+            });
+            return;
+        }
+
+        const quint64 requestId = queueIt->queued[priority].takeFirst();
+        auto it = m_requests.constFind(requestId);
+        if (it == m_requests.constEnd()) {
+            continue;
+        }
+        const qint64 waited = m_clock.elapsed() - it->queuedAt;
+        QueueStats &stats = queueIt->stats[priority];
+        ++stats.dispatched;
+        stats.totalWaitMs += waited;
+        stats.maxWaitMs = qMax(stats.maxWaitMs, waited);
+
+        ++queueIt->inFlight;
+        dispatch(requestId);
+        // dispatch 期间可能有新主机加入 m_hosts，重新查找以保证迭代器有效
+        queueIt = m_hosts.find(host);
+    }
+}
+
+void HttpManager::abortAll()
+{
+    const QList<quint64> ids = m_requests.keys();
+    for (quint64 id : ids) {
+        abort(id);
+    }
+}
+
+QSslConfiguration HttpManager::sslConfiguration(const QString &host) const
+{
+    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+    config.setProtocol(QSsl::SslProtocol::TlsV1_2OrLater);
+    config.setPeerVerifyMode(QSslSocket::VerifyNone);
+
+    // 通过 ALPN 协商 h2，服务器不支持时使用 HTTP/1.1
+    if (m_http2 && !m_http1Hosts.contains(host)) {
+        config.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+    } else {
+        config.setAllowedNextProtocols({QSslConfiguration::NextProtocolHttp1_1});
+    }
+
+    // 允许导出会话，并带上该主机保存的票据以尝试会话恢复
+    config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    auto it = m_sessionTickets.constFind(host);
+    if (it != m_sessionTickets.constEnd() && it->expires > QDateTime::currentSecsSinceEpoch()) {
+        config.setSessionTicket(it->ticket);
+    }
+    return config;
+}
+
+QSslConfiguration HttpManager::hostSslConfiguration(const QString &host)
+{
+    auto it = m_sslConfigs.constFind(host);
+    if (it == m_sslConfigs.constEnd()) {
+        it = m_sslConfigs.insert(host, sslConfiguration(host));
+    }
+    return *it;
+}
+
+void HttpManager::setSessionCacheFile(const QString &path)
+{
+    m_sessionFile = path;
+    loadSessionCache();
+}
+
+void HttpManager::loadSessionCache()
+{
+    m_sessionTickets.clear();
+    m_loadedTickets.clear();
+    m_sslConfigs.clear();
+
+    QFile file(m_sessionFile);
+    if (m_sessionFile.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    in >> magic;
+    if (magic != kSessionFileMagic) {
+        qWarning() << "Ignoring invalid TLS session cache:" << m_sessionFile;
+        return;
+    }
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    qint32 count = 0;
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString host;
+        SessionTicket session;
+        in >> host >> session.ticket >> session.expires;
+        if (session.expires > now && !session.ticket.isEmpty()) {
+            m_sessionTickets.insert(host, session);
+            m_loadedTickets.insert(session.ticket);
+        }
+    }
+    qDebug() << "Loaded" << m_sessionTickets.size() << "TLS session tickets";
+}
+
+void HttpManager::saveSessionCache()
+{
+    m_saveTimer.stop();
+    if (m_sessionFile.isEmpty()) {
+        return;
+    }
+
+    QFile file(m_sessionFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to save TLS session cache:" << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out << kSessionFileMagic << qint32(m_sessionTickets.size());
+    for (auto it = m_sessionTickets.constBegin(); it != m_sessionTickets.constEnd(); ++it) {
+        out << it.key() << it->ticket << it->expires;
+    }
+}
+
+void HttpManager::recordHandshake(QNetworkReply *reply, qint64 started)
+{
+    reply->setProperty("handshake", true);
+    reply->setProperty("handshakeMs", double(m_clock.elapsed() - started));
+}
+
+void HttpManager::recordSession(QNetworkReply *reply)
+{
+    // 预连接建立的连接被请求复用时不会发出 encrypted，因此在每个 https 回复结束时读取票据。
+    // 服务器接受票据时 OpenSSL 沿用原会话，导出的票据与发送的相同。复用连接上看不出是否新握手，
+    // 只有请求自己建立的连接或首次出现的、从文件加载的票据才计为一次恢复
+    const QSslConfiguration config = reply->sslConfiguration();
+    const QByteArray offered = reply->request().sslConfiguration().sessionTicket();
+    const QByteArray ticket = config.sessionTicket();
+    const QString host = reply->url().host();
+    if (!offered.isEmpty() && ticket == offered
+        && (m_loadedTickets.remove(ticket) || reply->property("handshake").toBool())) {
+        ++m_connectionStats[host].resumed;
+    }
+
+    if (!ticket.isEmpty() && ticket != m_sessionTickets.value(host).ticket) {
+        const int lifetime = config.sessionTicketLifeTimeHint() > 0 ? config.sessionTicketLifeTimeHint()
+                                                                    : kDefaultTicketLifetime;
+        m_sessionTickets.insert(host, {ticket, QDateTime::currentSecsSinceEpoch() + lifetime});
+        m_sslConfigs.remove(host);
+        if (!m_sessionFile.isEmpty()) {
+            m_saveTimer.start();
+        }
+    }
+}
+
+void HttpManager::preconnect(const QString &url)
+{
+    const QUrl target(url);
+    if (!target.isValid() || target.host().isEmpty()) {
+        return;
+    }
+
+    const QString host = target.host();
+    m_warmHosts.insert(host, target);
+    touch();
+
+    const qint64 now = m_clock.elapsed();
+    auto last = m_lastPreconnect.constFind(host);
+    if (last != m_lastPreconnect.constEnd() && now - last.value() < kPreconnectThrottle) {
+        return;
+    }
+    m_lastPreconnect.insert(host, now);
+
+    // 连接已在缓存中时 QNetworkAccessManager 不会重复建立
+    if (target.scheme() == "https") {
+        manager->connectToHostEncrypted(host, quint16(target.port(443)), hostSslConfiguration(host));
+    } else {
+        manager->connectToHost(host, quint16(target.port(80)));
+    }
+}
+
+void HttpManager::setKeepAlive(int intervalMs, int idleTimeoutMs)
+{
+    m_idleTimeout = qMax(0, idleTimeoutMs);
+    m_keepAliveEnabled = intervalMs > 0;
+    if (m_keepAliveEnabled) {
+        m_keepAliveTimer.setInterval(intervalMs);
+    } else {
+        m_keepAliveTimer.stop();
+    }
+}
+
+void HttpManager::touch()
+{
+    m_lastActivity = m_clock.elapsed();
+    if (m_keepAliveEnabled && m_idleTimeout > 0 && !m_keepAliveTimer.isActive()) {
+        m_keepAliveTimer.start();
+    }
+}
+
+void HttpManager::keepAlive()
+{
+    // 超过空闲时间后停止保温，让连接自然过期
+    if (m_lastActivity < 0 || m_clock.elapsed() - m_lastActivity > m_idleTimeout) {
+        m_keepAliveTimer.stop();
+        return;
+    }
+
+    const qint64 lastActivity = m_lastActivity;
+    for (const QUrl &url : std::as_const(m_warmHosts)) {
+        preconnect(url.toString());
+    }
+    m_lastActivity = lastActivity;  // 保温本身不算作活动
+}
+
+void HttpManager::recordConnection(QNetworkReply *reply)
+{
+    if (reply->url().scheme() != "https" || reply->error() != QNetworkReply::NoError) {
+        return;
+    }
+
+    recordSession(reply);
+
+    // 记录主机实际协商的协议，HTTP/2 主机按流数调度
+    const QString host = reply->url().host();
+    ConnectionStats &stats = m_connectionStats[host];
+    if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+        m_http2Hosts.insert(host);
+        ++stats.http2;
+    } else {
+        m_http2Hosts.remove(host);
+    }
+
+    // encrypted 信号只在新建 TLS 连接时发出，没有收到说明复用了已有连接
+    if (reply->property("handshake").toBool()) {
+        const double cost = reply->property("handshakeMs").toDouble();
+        stats.handshakeMs = stats.handshakes == 0 ? cost
+                                                  : kHandshakeEwmaAlpha * cost + (1 - kHandshakeEwmaAlpha) * stats.handshakeMs;
+        ++stats.handshakes;
+    } else {
+        ++stats.reused;
+        stats.avoidedMs += stats.handshakeMs;
+        if (stats.handshakeMs > 0) {
+            qDebug() << "Reused warm connection to" << reply->url().host()
+                     << ", avoided about" << qRound(stats.handshakeMs) << "ms of handshake";
+        }
+    }
+}
+
+QStringList HttpManager::connectionSummary() const
+{
+    QStringList lines;
+    for (auto it = m_connectionStats.constBegin(); it != m_connectionStats.constEnd(); ++it) {
+        lines.append(QString("%1  新建连接 %2（会话恢复 %3）  复用 %4  HTTP/2 %5  握手 %6ms  共节省 %7ms")
+                         .arg(it.key())
+                         .arg(it->handshakes)
+                         .arg(it->resumed)
+                         .arg(it->reused)
+                         .arg(it->http2)
+                         .arg(qRound(it->handshakeMs))
+                         .arg(qRound64(it->avoidedMs)));
+    }
+    return lines;
+}
+
+quint64 HttpManager::startRequest(const QNetworkRequest &request, const QByteArray &verb, const QByteArray &body,
+                                  Priority priority)
+{
+    const quint64 requestId = m_nextRequestId++;
+    PendingRequest pending;
+    pending.request = request;
+    if (request.url().scheme() == "https") {
+        pending.request.setSslConfiguration(hostSslConfiguration(request.url().host()));
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    // 空闲连接在保温期内不过期
+    if (m_idleTimeout > 0) {
+        pending.request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute,
+                                     m_idleTimeout / 1000);
+    }
+#endif
+    pending.verb = verb;
+    pending.body = body;
+    pending.priority = priority;
+
+    // 主机接受压缩请求体时以 gzip 发送，重试沿用压缩后的数据
+    const QString host = request.url().host();
+    TransferStats &transfer = m_transferStats[host];
+    transfer.requestBytes += body.size();
+    if (body.size() >= kMinCompressedBody && m_compressRequestHosts.contains(host)) {
+        const QByteArray compressed = BodyCodec::gzip(body);
+        if (!compressed.isEmpty() && compressed.size() < body.size()) {
+            pending.body = compressed;
+            pending.request.setRawHeader("Content-Encoding", "gzip");
+        }
+    }
+    transfer.requestWireBytes += pending.body.size();
+    m_requests.insert(requestId, pending);
+
+    // 超出主机并发数或速率限制时先排队，由 schedule 按优先级发出
+    enqueue(requestId, false);
+    return requestId;
+}
+
+void HttpManager::dispatch(quint64 requestId)
+{
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) return;
+
+    const QString host = it->request.url().host();
+    const bool http2 = m_http2 && !m_http1Hosts.contains(host);
+    it->request.setAttribute(QNetworkRequest::Http2AllowedAttribute, http2);
+    if (it->request.url().scheme() == QLatin1String("http")) {
+        it->request.setAttribute(QNetworkRequest::Http2DirectAttribute, http2 && m_http2Cleartext);
+    }
+    // 自行声明 Accept-Encoding 后 Qt 不再透明解压，readBody 收到的是线路上的原始数据；
+    // 没有 zlib 时不设置，仍由 Qt 解压
+    if (!m_responseCompression) {
+        it->request.setRawHeader("Accept-Encoding", "identity");
+    } else if (BodyCodec::isAvailable()) {
+        it->request.setRawHeader("Accept-Encoding", BodyCodec::acceptEncoding());
+    }
+    QNetworkReply *reply = manager->sendCustomRequest(it->request, it->verb, it->body);
+    if (!reply) {
+        // 调用方此时可能还没拿到请求 ID，失败通知放到事件循环中发出
+        m_requests.erase(it);
+        --m_hosts[host].inFlight;
+        QMetaObject::invokeMethod(this, [this, requestId]() {
+            emit sig_finished(requestId, QByteArray(), Failed);
+        }, Qt::QueuedConnection);
+        return;
+    }
+    reply->setProperty("requestId", requestId);
+    reply->setProperty("host", host);
+    it->reply = reply;
+    touch();
+
+    // 记录新建连接的耗时（DNS + TCP + TLS）
+    const qint64 started = m_clock.elapsed();
+    connect(reply, &QNetworkReply::encrypted, this, [this, reply, started]() {
+        recordHandshake(reply, started);
+    });
 
     // 创建超时计时器
     QTimer *timer = new QTimer(reply);
     timer->setSingleShot(true);
     connect(timer, &QTimer::timeout, this, &HttpManager::handleTimeout);
-    timer->start(timeout);
+    timer->start(hostTimeout(it->request.url().host()));
+
+    if (m_streaming) {
+        // 已取消或已被重试替换的回复不再交出数据
+        connect(reply, &QNetworkReply::readyRead, this, [this, reply, requestId]() {
+            auto it = m_requests.constFind(requestId);
+            if (it != m_requests.constEnd() && it->reply == reply) {
+                emitData(requestId, reply);
+            }
+        });
+    }
 
     connect(reply, &QNetworkReply::finished, this, &HttpManager::handleReply);
 }
 
-void HttpManager::sendGetRequest(const QString &url)
+quint64 HttpManager::sendGetRequest(const QString &url)
 {
     if (url.isEmpty()) {
         qWarning() << "Empty URL for GET request";
-        return;
+        return 0;
     }
 
-    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
-    config.setProtocol(QSsl::SslProtocol::TlsV1_2OrLater);
-    config.setPeerVerifyMode(QSslSocket::VerifyNone);
-
     QUrl requestUrl(url);
     if (!requestUrl.isValid()) {
         qWarning() << "Invalid URL:" << url;
-        return;
+        return 0;
     }
 
     QNetworkRequest request(requestUrl);
-    request.setSslConfiguration(config);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "*/*");
     request.setRawHeader("Accept", "*/*");
     request.setRawHeader("Connection", "keep-alive");
 
-    setupReply(manager->get(request));
+    return startRequest(request, "GET", QByteArray());
 }
 
-void HttpManager::sendPostRequest(const QString &url, const QJsonObject &data, const QMap<QString, QString> &headers)
+quint64 HttpManager::sendPostRequest(const QString &url, const QJsonObject &data, const QMap<QString, QString> &headers)
+{
+    return sendPostRequest(url, QJsonDocument(data).toJson(QJsonDocument::Compact), headers);
+}
+
+quint64 HttpManager::sendPostRequest(const QString &url, const QByteArray &data, const QMap<QString, QString> &headers)
 {
     if (url.isEmpty()) {
         qWarning() << "Empty URL for POST request";
-        return;
+        return 0;
     }
+    return sendPostRequest(prepareRequest(url, headers), data);
+}
 
-    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
-    config.setProtocol(QSsl::SslProtocol::TlsV1_2OrLater);
-    config.setPeerVerifyMode(QSslSocket::VerifyNone);
-
+QNetworkRequest HttpManager::prepareRequest(const QString &url, const QMap<QString, QString> &headers) const
+{
     QUrl requestUrl(url);
     if (!requestUrl.isValid()) {
         qWarning() << "Invalid URL:" << url;
-        return;
+        return QNetworkRequest();
     }
 
     QNetworkRequest request(requestUrl);
-    request.setSslConfiguration(config);
 
     // 设置默认请求头
     request.setRawHeader("Accept", "*/*");
@@ -130,7 +799,13 @@ void HttpManager::sendPostRequest(const QString &url, const QJsonObject &data, c
     for (auto it = headers.constBegin(); it != headers.constEnd(); ++it) {
         request.setRawHeader(it.key().toUtf8(), it.value().toUtf8());
     }
+    return request;
+}
 
-    QByteArray postData = QJsonDocument(data).toJson(QJsonDocument::Compact);
-    setupReply(manager->post(request, postData));
+quint64 HttpManager::sendPostRequest(const QNetworkRequest &request, const QByteArray &data, Priority priority)
+{
+    if (!request.url().isValid()) {
+        return 0;
+    }
+    return startRequest(request, "POST", data, priority);
 }
@@ -3,30 +3,208 @@
 
 #include <QObject>
 #include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QSslConfiguration>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
 
 class HttpManager : public QObject
 {
     Q_OBJECT
 public:
+    // 请求的最终结果
+    enum RequestStatus {
+        Succeeded,
+        Failed,
+        TimedOut
+    };
+    Q_ENUM(RequestStatus)
+
+    // 调度优先级：交互请求总是先于批量请求发出
+    enum Priority {
+        Interactive,
+        Bulk,
+        PriorityCount
+    };
+    Q_ENUM(Priority)
+
     explicit HttpManager(QObject *parent = nullptr);
     ~HttpManager();
 
-    void sendGetRequest(const QString &url);
-    void sendPostRequest(const QString &url, const QJsonObject &data, const QMap<QString, QString> &headers);
+    // 发送请求并返回请求 ID（失败时返回 0），结果通过 sig_finished 带 ID 返回
+    quint64 sendGetRequest(const QString &url);
+    quint64 sendPostRequest(const QString &url, const QJsonObject &data, const QMap<QString, QString> &headers);
+    // 发送已序列化的请求体，便于在其他线程中提前构建
+    quint64 sendPostRequest(const QString &url, const QByteArray &data, const QMap<QString, QString> &headers);
+    // 预先构建带请求头的请求，之后每次发送只拷贝（隐式共享），不再逐个转换请求头
+    QNetworkRequest prepareRequest(const QString &url, const QMap<QString, QString> &headers) const;
+    quint64 sendPostRequest(const QNetworkRequest &request, const QByteArray &data, Priority priority = Interactive);
+
+    // 取消请求，被取消的请求不会再发出 sig_finished
+    void abort(quint64 requestId);
+    void abortAll();
+    bool isPending(quint64 requestId) const { return m_requests.contains(requestId); }
+
+    // 按主机设置超时时间，未设置的主机使用默认值
+    void setHostTimeout(const QString &host, int ms) { m_hostTimeouts.insert(host, ms); }
+    int hostTimeout(const QString &host) const { return m_hostTimeouts.value(host, timeout); }
+    void setMaxRetries(int maxRetries) { m_maxRetries = qMax(0, maxRetries); }
+
+    // 调度限制：每个主机同时进行的请求数，以及按令牌桶限制的每秒请求数（0 表示不限）
+    void setMaxInFlightPerHost(int maxInFlight) { m_maxInFlightPerHost = qMax(1, maxInFlight); }
+    void setHostRateLimit(const QString &host, double requestsPerSecond, int burst);
+    int queueDepth(const QString &host) const;
+
+    // 每个主机各优先级的排队统计
+    struct QueueStats {
+        quint64 dispatched{0};
+        qint64 totalWaitMs{0};
+        qint64 maxWaitMs{0};
+        int maxDepth{0};
+    };
+    QueueStats queueStats(const QString &host, Priority priority) const;
+    QStringList queueSummary() const;
+    // HTTP/2：与支持的主机协商 h2，同一主机的并发请求复用一条连接，并发上限改为 maxStreams；
+    // 主机不支持时由 ALPN 协商为 HTTP/1.1，h2 请求出现协议错误时该主机改用 HTTP/1.1 重试
+    void setHttp2Enabled(bool enabled);
+    // 明文 http:// 主机没有 ALPN，开启后以 prior knowledge 直接发送 h2c（本地模拟服务的 --h2）
+    void setHttp2Cleartext(bool enabled) { m_http2Cleartext = enabled; }
+    void setMaxStreamsPerHost(int maxStreams) { m_maxStreamsPerHost = qMax(1, maxStreams); }
+    bool isHttp2Host(const QString &host) const { return m_http2Hosts.contains(host); }
+    // 响应压缩：声明能解压的编码（gzip、deflate，可用时还有 br），数据到达时流式解压，
+    // 关闭时要求服务器不压缩；请求压缩：对接受压缩请求体的主机，较大的请求体以 gzip 发送
+    void setResponseCompression(bool enabled) { m_responseCompression = enabled; }
+    void setHostRequestCompression(const QString &host, bool enabled);
+
+    // 每个主机的消息体字节数：logical 为压缩前（解压后）的大小，wire 为实际收发的大小
+    struct TransferStats {
+        quint64 requestBytes{0};
+        quint64 requestWireBytes{0};
+        quint64 responseBytes{0};
+        quint64 responseWireBytes{0};
+        quint64 compressedResponses{0};
+    };
+    TransferStats transferStats(const QString &host) const { return m_transferStats.value(host); }
+    QStringList transferSummary() const;
+    // 流式模式：响应体随到达通过 sig_dataReceived 分段交出，sig_finished 不再携带数据
+    void setStreaming(bool enabled) { m_streaming = enabled; }
+
+    // 预先建立到目标主机的连接（DNS、TCP、TLS 握手），之后的请求直接复用
+    void preconnect(const QString &url);
+    // 连接保温：最近 idleTimeout 内有活动的主机每隔 interval 重新预连接一次
+    void setKeepAlive(int intervalMs, int idleTimeoutMs);
+    // 标记主机即将被使用（例如按下热键修饰键时），重新开始保温计时
+    void touch();
+
+    // 每个主机的连接复用统计
+    struct ConnectionStats {
+        quint64 handshakes{0};      // 请求时新建连接的次数
+        quint64 resumed{0};         // 其中通过 TLS 会话恢复完成的简化握手次数
+        quint64 reused{0};          // 复用已有连接的次数
+        quint64 http2{0};           // 通过 HTTP/2 完成的请求数
+        double handshakeMs{0};      // 新建连接耗时的 EWMA
+        double avoidedMs{0};        // 复用连接累计节省的握手时间
+    };
+    ConnectionStats connectionStats(const QString &host) const { return m_connectionStats.value(host); }
+    QStringList connectionSummary() const;
+
+    // TLS 会话票据持久化到文件，重启后首次连接即可使用简化握手
+    void setSessionCacheFile(const QString &path);
+    void saveSessionCache();
 
 signals:
-    void sig_finished(QByteArray data);
+    // first 表示本次尝试的第一段数据，重试后会重新从 first 开始
+    void sig_dataReceived(quint64 requestId, QByteArray data, bool first);
+    void sig_finished(quint64 requestId, QByteArray data, HttpManager::RequestStatus status);
 
 private slots:
     void handleReply();
     void handleTimeout();
+    void keepAlive();
 
 private:
-    void setupReply(QNetworkReply *reply);
+    struct PendingRequest {
+        QNetworkRequest request;
+        QByteArray verb;
+        QByteArray body;
+        QNetworkReply *reply{nullptr};  // 排队和退避等待重试期间为空
+        int attempt{0};
+        Priority priority{Interactive};
+        qint64 queuedAt{0};
+    };
+
+    // 每个主机的请求队列和令牌桶
+    struct HostQueue {
+        QList<quint64> queued[PriorityCount];
+        int inFlight{0};
+        double rate{0};         // 每秒令牌数，0 表示不限
+        int burst{1};
+        double tokens{0};
+        qint64 refilledAt{-1};
+        bool waiting{false};    // 已安排定时器等待下一个令牌
+        QueueStats stats[PriorityCount];
+    };
+
+    quint64 startRequest(const QNetworkRequest &request, const QByteArray &verb, const QByteArray &body,
+                         Priority priority = Interactive);
+    void enqueue(quint64 requestId, bool front);
+    void schedule(const QString &host);
+    bool takeToken(HostQueue &queue, int *waitMs);
+    void dispatch(quint64 requestId);
+    bool isTransientError(QNetworkReply *reply) const;
+    bool isHttp2Failure(QNetworkReply *reply) const;
+    int retryDelay(int attempt) const;
+    QSslConfiguration sslConfiguration(const QString &host) const;
+    QSslConfiguration hostSslConfiguration(const QString &host);
+    void recordConnection(QNetworkReply *reply);
+    void emitData(quint64 requestId, QNetworkReply *reply);
+    QByteArray readBody(QNetworkReply *reply);
+    void recordHandshake(QNetworkReply *reply, qint64 started);
+    void recordSession(QNetworkReply *reply);
+    void loadSessionCache();
     
     QNetworkAccessManager *manager;
     const int timeout;  // 超时时间（毫秒）
+    int m_maxRetries{2};
+    int m_maxInFlightPerHost{6};
+    int m_maxStreamsPerHost{100};
+    bool m_http2{true};
+    bool m_http2Cleartext{false};
+    QSet<QString> m_http2Hosts;   // 最近一次请求使用了 HTTP/2 的主机
+    QSet<QString> m_http1Hosts;   // h2 出错后只使用 HTTP/1.1 的主机
+    QHash<QString, HostQueue> m_hosts;
+    bool m_streaming{false};
+    bool m_responseCompression{true};
+    QSet<QString> m_compressRequestHosts;
+    QHash<QString, TransferStats> m_transferStats;
+    quint64 m_nextRequestId{1};
+    QHash<quint64, PendingRequest> m_requests;  // 进行中的请求
+    QHash<QString, int> m_hostTimeouts;
+
+    // 连接预热和保温
+    QElapsedTimer m_clock;
+    QTimer m_keepAliveTimer;
+    bool m_keepAliveEnabled{true};  // 间隔设为 0 时关闭保温
+    int m_idleTimeout{10 * 60 * 1000};
+    qint64 m_lastActivity{-1};
+    QHash<QString, QUrl> m_warmHosts;           // 主机 -> 预连接地址
+    QHash<QString, qint64> m_lastPreconnect;    // 主机 -> 上次预连接时间
+    QHash<QString, ConnectionStats> m_connectionStats;
+
+    // TLS 会话票据
+    struct SessionTicket {
+        QByteArray ticket;
+        qint64 expires{0};  // 过期时间（UTC 秒）
+    };
+    QString m_sessionFile;
+    QHash<QString, SessionTicket> m_sessionTickets;  // 主机 -> 会话票据
+    QSet<QByteArray> m_loadedTickets;                // 从文件加载、尚未在连接上出现过的票据
+    QHash<QString, QSslConfiguration> m_sslConfigs;  // 主机 -> 已构建的 TLS 配置，票据变化时失效
+    QTimer m_saveTimer;
 };
 
 #endif // HTTPMANAGER_H
@@ -0,0 +1,94 @@
+#include "keyeventsource.h"
+#include "latencytracer.h"
+
+#include <QDebug>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+namespace {
+// 钩子回调没有上下文参数，通过线程局部变量找到本线程的事件来源
+thread_local WindowsKeyEventSource *t_source = nullptr;
+}
+
+void WindowsKeyEventSource::run(const Handler &handler)
+{
+    m_handler = handler;
+    t_source = this;
+
+    // 先创建线程消息队列，保证 stop 发出的 WM_QUIT 能够送达
+    MSG msg;
+    PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+    m_threadId = GetCurrentThreadId();
+    if (m_stopping) {
+        return;
+    }
+
+    HHOOK hook = SetWindowsHookEx(WH_KEYBOARD_LL, hookProc, GetModuleHandle(NULL), 0);
+    if (hook == NULL) {
+        qDebug() << "Failed to install keyboard hook. Error:" << GetLastError();
+        return;
+    }
+
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    if (!UnhookWindowsHookEx(hook)) {
+        qDebug() << "Failed to uninstall hook. Error:" << GetLastError();
+    }
+    t_source = nullptr;
+}
+
+void WindowsKeyEventSource::stop()
+{
+    m_stopping = true;
+    if (const DWORD threadId = m_threadId) {
+        PostThreadMessage(threadId, WM_QUIT, 0, 0);
+    }
+}
+
+LRESULT CALLBACK WindowsKeyEventSource::hookProc(int nCode, WPARAM wParam, LPARAM lParam)
+{
+    if (nCode >= 0 && t_source && (wParam == WM_KEYDOWN || wParam == WM_KEYUP)) {
+        const KBDLLHOOKSTRUCT *pKeyInfo = reinterpret_cast<KBDLLHOOKSTRUCT *>(lParam);
+
+        KeyEvent event;
+        event.time = LatencyTracer::now();
+        event.down = wParam == WM_KEYDOWN;
+        if (pKeyInfo->vkCode == VK_LCONTROL || pKeyInfo->vkCode == VK_RCONTROL) {
+            event.key = KeyEvent::Control;
+        } else if (pKeyInfo->vkCode == 'C') {
+            event.key = KeyEvent::C;
+        }
+        if (event.key != KeyEvent::Other) {
+            t_source->m_handler(event);
+        }
+    }
+    return CallNextHookEx(NULL, nCode, wParam, lParam);
+}
+#endif
+
+QList<SyntheticKeyEventSource::Step> SyntheticKeyEventSource::repeatedCopy(int presses, int intervalUs)
+{
+    QList<Step> script{{KeyEvent::Control, true, intervalUs}};
+    for (int i = 0; i < presses; ++i) {
+        script.append({KeyEvent::C, true, intervalUs});
+        script.append({KeyEvent::C, false, intervalUs / 2});
+    }
+    script.append({KeyEvent::Control, false, intervalUs});
+    return script;
+}
+
+void SyntheticKeyEventSource::run(const Handler &handler)
+{
+    for (const Step &step : std::as_const(m_script)) {
+        if (step.delayUs > 0) {
+            QThread::usleep(step.delayUs);
+        }
+        if (m_stopping) {
+            return;
+        }
+        handler({step.key, step.down, LatencyTracer::now()});
+    }
+}
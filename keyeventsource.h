@@ -0,0 +1,77 @@
+#ifndef KEYEVENTSOURCE_H
+#define KEYEVENTSOURCE_H
+
+#include <QList>
+#include <atomic>
+#include <functional>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+// 与平台无关的按键事件，只区分热键检测关心的按键
+struct KeyEvent
+{
+    enum Key {
+        Other,
+        Control,
+        C
+    };
+
+    Key key{Other};
+    bool down{false};
+    qint64 time{0};  // LatencyTracer::now()
+};
+
+// 按键事件来源。run 在调用线程上阻塞运行自己的消息循环，每个事件都在该线程上回调 handler，
+// 直到另一线程调用 stop
+class KeyEventSource
+{
+public:
+    using Handler = std::function<void(const KeyEvent &)>;
+
+    virtual ~KeyEventSource() = default;
+    virtual void run(const Handler &handler) = 0;
+    virtual void stop() = 0;
+};
+
+#ifdef Q_OS_WIN
+// 系统级低级键盘钩子（WH_KEYBOARD_LL），钩子回调在 run 所在线程的消息循环中执行
+class WindowsKeyEventSource : public KeyEventSource
+{
+public:
+    void run(const Handler &handler) override;
+    void stop() override;
+
+private:
+    static LRESULT CALLBACK hookProc(int nCode, WPARAM wParam, LPARAM lParam);
+
+    Handler m_handler;
+    std::atomic<DWORD> m_threadId{0};
+    std::atomic<bool> m_stopping{false};
+};
+#endif
+
+// 按脚本产生按键事件，用于在没有全局钩子的平台上测试检测逻辑和投递延迟
+class SyntheticKeyEventSource : public KeyEventSource
+{
+public:
+    struct Step {
+        KeyEvent::Key key;
+        bool down;
+        int delayUs;  // 距上一个事件的间隔
+    };
+
+    explicit SyntheticKeyEventSource(const QList<Step> &script) : m_script(script) {}
+
+    // 按住 Ctrl 连按 presses 次 C，每次按键间隔 intervalUs 微秒
+    static QList<Step> repeatedCopy(int presses, int intervalUs);
+
+    void run(const Handler &handler) override;
+    void stop() override { m_stopping = true; }
+
+private:
+    QList<Step> m_script;
+    std::atomic<bool> m_stopping{false};
+};
+
+#endif // KEYEVENTSOURCE_H
@@ -0,0 +1,189 @@
+#include "lagprobe.h"
+#include "mockserver.h"
+#include "translator.h"
+
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const int kBenchTimeout = 10 * 60 * 1000;  // 单次翻译的最长等待时间（毫秒）
+
+// 各不相同的英文句子，每 6 句一段，避免句子级去重和缓存让请求变少
+QString benchText(qsizetype size, int run)
+{
+    QString text;
+    text.reserve(size + 128);
+    for (int i = 0; text.size() < size; ++i) {
+        text += QString("Run %1, sentence %2: the quick brown fox jumps over the lazy dog near the river bank.")
+                    .arg(run)
+                    .arg(i);
+        text += i % 6 == 5 ? "\n" : " ";
+    }
+    return text;
+}
+}
+
+LagProbe::LagProbe(int intervalMs, QObject *parent)
+    : QObject{parent}
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(intervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &LagProbe::tick);
+}
+
+void LagProbe::start()
+{
+    m_lagsUs.clear();
+    m_clock.start();
+    m_timer.start();
+}
+
+void LagProbe::stop()
+{
+    m_timer.stop();
+}
+
+void LagProbe::tick()
+{
+    const qint64 elapsedUs = m_clock.nsecsElapsed() / 1000;
+    m_clock.start();
+    m_lagsUs.append(qMax<qint64>(0, elapsedUs - m_timer.interval() * 1000));
+}
+
+qint64 LagProbe::maxUs() const
+{
+    return m_lagsUs.isEmpty() ? 0 : *std::max_element(m_lagsUs.cbegin(), m_lagsUs.cend());
+}
+
+qint64 LagProbe::percentileUs(double percentile) const
+{
+    if (m_lagsUs.isEmpty()) {
+        return 0;
+    }
+    QList<qint64> sorted = m_lagsUs;
+    std::sort(sorted.begin(), sorted.end());
+    const qsizetype index = qBound<qsizetype>(0, qsizetype(percentile * sorted.size()), sorted.size() - 1);
+    return sorted.at(index);
+}
+
+bool LagProbe::isBenchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--lag-bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int LagProbe::benchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Event-loop lag while translating a large input, with and without the request pipeline.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("lag-bench", "Input size in KB.", "kb", "1024");
+    QCommandLineOption urlOption("url", "Use a running provider or mock server instead of starting one.", "url");
+    QCommandLineOption latencyOption("latency", "Response latency of the built-in mock server in ms.", "ms", "20");
+    QCommandLineOption chunkSizeOption("chunk-size", "Maximum characters per request.", "n", "2000");
+    QCommandLineOption concurrencyOption({"j", "concurrency"}, "Requests in flight.", "n", "8");
+    parser.addOptions({benchOption, urlOption, latencyOption, chunkSizeOption, concurrencyOption});
+    parser.process(arguments);
+
+    QTextStream err(stderr);
+    QString url = parser.value(urlOption);
+
+    // 模拟服务在自己的线程上运行，它处理请求的开销不计入被测的事件循环
+    QThread serverThread;
+    MockServer *server = nullptr;
+    if (url.isEmpty()) {
+        server = new MockServer;
+        server->parseArguments({arguments.first(), "--mock-server", "--port", "0",
+                                "--latency", parser.value(latencyOption)});
+        server->moveToThread(&serverThread);
+        serverThread.start();
+        quint16 port = 0;
+        QMetaObject::invokeMethod(server, [server, &port]() {
+            if (server->listen()) {
+                port = server->serverPort();
+            }
+        }, Qt::BlockingQueuedConnection);
+        if (port == 0) {
+            QMetaObject::invokeMethod(server, [server]() { delete server; }, Qt::BlockingQueuedConnection);
+            serverThread.quit();
+            serverThread.wait();
+            return 1;
+        }
+        url = QString("http://127.0.0.1:%1").arg(port);
+    }
+
+    const qsizetype size = qMax(1, parser.value(benchOption).toInt()) * qsizetype(1024);
+    int status = 0;
+    int run = 0;
+    for (const bool pipeline : {true, false}) {
+        Translator translator;
+        translator.setBaseUrl(API_VERSION::V1, url);
+        translator.setBaseUrl(API_VERSION::V2, url);
+        translator.setApiVersion(API_VERSION::V1);
+        translator.setHedging(false);
+        translator.setAutoSelect(false);
+        translator.setPipelineEnabled(pipeline);
+        translator.setChunkSize(parser.value(chunkSizeOption).toInt());
+        translator.setMaxInFlight(parser.value(concurrencyOption).toInt());
+
+        // 与界面一样在事件循环线程上拼接译文
+        QString result;
+        bool ok = false;
+        bool done = false;
+        QEventLoop loop;
+        QObject::connect(&translator, &Translator::sig_chunkFinished, &loop,
+                         [&result](quint64, int, const QString &text) { result += text; });
+        QObject::connect(&translator, &Translator::sig_jobFinished, &loop,
+                         [&ok, &done, &loop](quint64, bool success) {
+            ok = success;
+            done = true;
+            loop.quit();
+        });
+        QTimer::singleShot(kBenchTimeout, &loop, &QEventLoop::quit);
+
+        const QString text = benchText(size, run++);
+        LagProbe probe;
+        QElapsedTimer timer;
+        timer.start();
+        probe.start();
+        const quint64 jobId = translator.createJob(text);
+        const int chunks = translator.chunkCount(jobId);
+        translator.start(jobId);
+        if (!done) {
+            loop.exec();
+        }
+        probe.stop();
+
+        err << QString("pipeline %1: %2 KB in %3 chunks, %4 ms, %5 KB of results%6\n")
+                   .arg(pipeline ? "on " : "off")
+                   .arg(text.size() / 1024)
+                   .arg(chunks)
+                   .arg(timer.elapsed())
+                   .arg(result.size() / 1024)
+                   .arg(ok ? "" : "  (failed)");
+        err << QString("  event-loop lag: max %1 ms  p99 %2 ms  p50 %3 ms  (%4 samples)\n")
+                   .arg(probe.maxUs() / 1000.0, 0, 'f', 1)
+                   .arg(probe.percentileUs(0.99) / 1000.0, 0, 'f', 1)
+                   .arg(probe.percentileUs(0.5) / 1000.0, 0, 'f', 1)
+                   .arg(probe.samples());
+        if (!ok) {
+            status = 2;
+        }
+    }
+
+    if (server) {
+        QMetaObject::invokeMethod(server, [server]() { delete server; }, Qt::BlockingQueuedConnection);
+        serverThread.quit();
+        serverThread.wait();
+    }
+    err.flush();
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef LAGPROBE_H
+#define LAGPROBE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+// 事件循环延迟探针：以固定间隔触发的精确定时器，记录每次实际触发时间比预期晚了多少。
+// 所在线程的事件循环被长时间占用时延迟随之增大，用于衡量 GUI 线程的卡顿。
+class LagProbe : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LagProbe(int intervalMs = 10, QObject *parent = nullptr);
+
+    void start();
+    void stop();
+    int samples() const { return m_lagsUs.size(); }
+    qint64 maxUs() const;
+    qint64 percentileUs(double percentile) const;
+
+    // --lag-bench：开启和关闭请求流水线各翻译一次约 1 MB 的文本，比较事件循环延迟的最大值和 p99。
+    // 默认在独立线程上启动本地模拟服务，也可用 --url 指向已在运行的服务
+    static bool isBenchMode(int argc, char *argv[]);
+    static int benchmark(const QStringList &arguments);
+
+private:
+    void tick();
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QList<qint64> m_lagsUs;
+};
+
+#endif // LAGPROBE_H
@@ -0,0 +1,253 @@
+#include "latencytracer.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+namespace {
+const int kMaxFinishedTraces = 256;
+
+QString formatMs(qint64 us)
+{
+    return QString::number(us / 1000.0, 'f', 1);
+}
+}
+
+int LatencyTracer::Histogram::bucketOf(qint64 us)
+{
+    if (us < LinearLimit) {
+        return int(qMax<qint64>(0, us));
+    }
+    // 最高位决定所在的 2 倍区间，其后 SubBucketBits 位决定区间内的子桶
+    const int exponent = 63 - qCountLeadingZeroBits(quint64(us));
+    const int shift = exponent - SubBucketBits;
+    const int sub = int(us >> shift) & ((1 << SubBucketBits) - 1);
+    const int bucket = LinearLimit + (exponent - SubBucketBits - 1) * (1 << SubBucketBits) + sub;
+    return qMin(bucket, BucketCount - 1);
+}
+
+qint64 LatencyTracer::Histogram::lowerBound(int bucket)
+{
+    if (bucket < LinearLimit) {
+        return bucket;
+    }
+    const int octave = (bucket - LinearLimit) >> SubBucketBits;
+    const int sub = (bucket - LinearLimit) & ((1 << SubBucketBits) - 1);
+    const int shift = octave + 1;
+    return qint64((1 << SubBucketBits) + sub) << shift;
+}
+
+qint64 LatencyTracer::Histogram::upperBound(int bucket)
+{
+    return lowerBound(bucket + 1);  // 对 BucketCount 同样成立，即 2^26
+}
+
+void LatencyTracer::Histogram::record(qint64 us)
+{
+    us = qMax<qint64>(0, us);
+    ++buckets[bucketOf(us)];
+    ++count;
+    sumUs += us;
+    maxUs = qMax(maxUs, us);
+}
+
+qint64 LatencyTracer::Histogram::percentile(double p) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    const quint64 rank = qMax<quint64>(1, quint64(p * count + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin((lowerBound(i) + upperBound(i)) / 2, maxUs);
+        }
+    }
+    return maxUs;
+}
+
+qint64 LatencyTracer::now()
+{
+    static const QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed();
+}
+
+QString LatencyTracer::stageName(Stage stage)
+{
+    switch (stage) {
+    case KeyHandled:    return "key_handled";
+    case Clipboard:     return "clipboard";
+    case WindowShown:   return "window_shown";
+    case JobCreated:    return "job_created";
+    case RequestSent:   return "request_sent";
+    case FirstByte:     return "first_byte";
+    case ReplyFinished: return "reply_finished";
+    case Parsed:        return "parsed";
+    case Rendered:      return "rendered";
+    case StageCount:    break;
+    }
+    return QString();
+}
+
+quint64 LatencyTracer::begin(qint64 start)
+{
+    Trace trace;
+    trace.id = m_nextId++;
+    trace.start = start > 0 ? start : now();
+    m_active.insert(trace.id, trace);
+    return trace.id;
+}
+
+void LatencyTracer::mark(quint64 traceId, Stage stage, qint64 timestamp)
+{
+    auto it = m_active.find(traceId);
+    if (it == m_active.end() || it->stamps[stage] != 0) {
+        return;
+    }
+    it->stamps[stage] = timestamp > 0 ? timestamp : now();
+}
+
+void LatencyTracer::setLabel(quint64 traceId, const QString &label)
+{
+    auto it = m_active.find(traceId);
+    if (it != m_active.end()) {
+        it->label = label;
+    }
+}
+
+void LatencyTracer::discard(quint64 traceId)
+{
+    m_active.remove(traceId);
+}
+
+void LatencyTracer::finish(quint64 traceId)
+{
+    auto it = m_active.find(traceId);
+    if (it == m_active.end()) {
+        return;
+    }
+    const Trace trace = *it;
+    m_active.erase(it);
+
+    // 各阶段按经过的顺序计算与上一个阶段的间隔，没有经过的阶段不计入
+    qint64 previous = trace.start;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const qint64 stamp = trace.stamps[stage];
+        if (stamp == 0) {
+            continue;
+        }
+        m_stages[stage].record((stamp - previous) / 1000);
+        previous = qMax(previous, stamp);
+    }
+    m_totals[trace.label.isEmpty() ? QStringLiteral("-") : trace.label].record((previous - trace.start) / 1000);
+
+    m_finished.append(trace);
+    if (m_finished.size() > kMaxFinishedTraces) {
+        m_finished.removeFirst();
+    }
+}
+
+QStringList LatencyTracer::summary() const
+{
+    QStringList lines;
+    for (auto it = m_totals.constBegin(); it != m_totals.constEnd(); ++it) {
+        lines.append(QString("端到端 %1  %2 次  p50 %3 ms  p95 %4 ms  最大 %5 ms")
+                         .arg(it.key())
+                         .arg(it->count)
+                         .arg(formatMs(it->percentile(0.5)))
+                         .arg(formatMs(it->percentile(0.95)))
+                         .arg(formatMs(it->maxUs)));
+    }
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const Histogram &histogram = m_stages[stage];
+        if (histogram.count == 0) {
+            continue;
+        }
+        lines.append(QString("%1  p50 %2 ms  p95 %3 ms  最大 %4 ms")
+                         .arg(stageName(Stage(stage)))
+                         .arg(formatMs(histogram.percentile(0.5)))
+                         .arg(formatMs(histogram.percentile(0.95)))
+                         .arg(formatMs(histogram.maxUs)));
+    }
+    return lines;
+}
+
+bool LatencyTracer::writeChromeTrace(const QString &path) const
+{
+    // 每条 trace 占一行（tid），各阶段是一段完整事件（ph = X），时间单位为微秒
+    QJsonArray events;
+    for (const Trace &trace : m_finished) {
+        events.append(QJsonObject{
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", qint64(trace.id)},
+            {"args", QJsonObject{{"name", QString("#%1 %2").arg(trace.id).arg(trace.label)}}}});
+
+        qint64 previous = trace.start;
+        for (int stage = 0; stage < StageCount; ++stage) {
+            const qint64 stamp = trace.stamps[stage];
+            if (stamp == 0) {
+                continue;
+            }
+            events.append(QJsonObject{
+                {"name", stageName(Stage(stage))}, {"cat", "translate"}, {"ph", "X"},
+                {"pid", 1}, {"tid", qint64(trace.id)},
+                {"ts", previous / 1000.0}, {"dur", qMax<qint64>(0, stamp - previous) / 1000.0},
+                {"args", QJsonObject{{"provider", trace.label}}}});
+            previous = qMax(previous, stamp);
+        }
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const QJsonObject root{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) > 0;
+}
+
+bool LatencyTracer::writeMetrics(const QString &path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+
+    // Prometheus 文本格式，桶的上界和总和以秒为单位，桶计数为累计值
+    QTextStream out(&file);
+    auto writeHistogram = [&out](const QString &name, const QString &labels, const Histogram &histogram) {
+        quint64 cumulative = 0;
+        for (int i = 0; i < Histogram::BucketCount; ++i) {
+            cumulative += histogram.buckets[i];
+            // 只在 2 的幂处输出累计值，与细分前的桶边界一致，避免每个序列上百行
+            const qint64 bound = Histogram::upperBound(i);
+            if ((bound & (bound - 1)) == 0) {
+                out << name << "_bucket{" << labels << ",le=\"" << QString::number(bound / 1e6, 'g', 9)
+                    << "\"} " << cumulative << '\n';
+            }
+        }
+        out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count << '\n';
+        out << name << "_sum{" << labels << "} " << QString::number(histogram.sumUs / 1e6, 'f', 6) << '\n';
+        out << name << "_count{" << labels << "} " << histogram.count << '\n';
+    };
+
+    out << "# HELP translate_stage_seconds Time spent in each stage from hotkey to rendered text.\n";
+    out << "# TYPE translate_stage_seconds histogram\n";
+    for (int stage = 0; stage < StageCount; ++stage) {
+        writeHistogram("translate_stage_seconds", QString("stage=\"%1\"").arg(stageName(Stage(stage))), m_stages[stage]);
+    }
+    out << "# HELP translate_total_seconds End-to-end translation latency per provider.\n";
+    out << "# TYPE translate_total_seconds histogram\n";
+    for (auto it = m_totals.constBegin(); it != m_totals.constEnd(); ++it) {
+        writeHistogram("translate_total_seconds", QString("provider=\"%1\"").arg(it.key()), *it);
+    }
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
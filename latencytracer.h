@@ -0,0 +1,80 @@
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// 从热键到译文显示的端到端耗时跟踪。每次翻译对应一条 trace，各阶段用单调时钟打点，
+// 结束后按阶段计入直方图；可导出为 Chrome trace（chrome://tracing、Perfetto）和
+// Prometheus 文本格式的指标文件
+class LatencyTracer
+{
+public:
+    // 每个阶段的耗时从上一个经过的阶段（或 trace 开始）算起
+    enum Stage {
+        KeyHandled,     // 键盘钩子识别到热键后，排队的 keyDownHandle 开始执行
+        Clipboard,      // 读取剪贴板
+        WindowShown,    // 显示并激活窗口
+        JobCreated,     // 识别标记、切分句子、检测语言
+        RequestSent,    // 首个请求体构建完毕并交给网络层
+        FirstByte,      // 首个响应数据到达（仅流式解码模式）
+        ReplyFinished,  // 首个响应接收完毕
+        Parsed,         // 首个响应解析完毕
+        Rendered,       // 首段译文写入结果面板
+        StageCount
+    };
+
+    // 按 2 的幂分桶的直方图，第 i 个桶记录 [2^i, 2^(i+1)) 微秒
+    // 对数分桶的直方图（类似 HdrHistogram）：16 µs 以下每微秒一个桶，之后每个 2 倍区间再分 8 个桶，
+    // 相对误差不超过 12.5%，最大记录约 67 秒
+    struct Histogram {
+        static constexpr int SubBucketBits = 3;
+        static constexpr int LinearLimit = 2 << SubBucketBits;  // 16 µs
+        static constexpr int BucketCount = LinearLimit + (26 - SubBucketBits - 1) * (1 << SubBucketBits);
+        quint64 buckets[BucketCount]{};
+        quint64 count{0};
+        qint64 sumUs{0};
+        qint64 maxUs{0};
+
+        void record(qint64 us);
+        qint64 percentile(double p) const;  // 所在桶的中点（微秒），不超过最大值
+        static int bucketOf(qint64 us);
+        static qint64 lowerBound(int bucket);
+        static qint64 upperBound(int bucket);  // 不含
+    };
+
+    static qint64 now();  // 单调时钟，纳秒
+    static QString stageName(Stage stage);
+
+    // start 为 0 时从当前时间开始，热键触发时传入钩子中记录的时间
+    quint64 begin(qint64 start = 0);
+    // 同一阶段只记录第一次，多批次任务以最先到达的批次为准；traceId 为 0 时忽略
+    void mark(quint64 traceId, Stage stage, qint64 timestamp = 0);
+    void setLabel(quint64 traceId, const QString &label);
+    void finish(quint64 traceId);
+    void discard(quint64 traceId);
+
+    const Histogram &histogram(Stage stage) const { return m_stages[stage]; }
+    QStringList summary() const;
+    bool writeChromeTrace(const QString &path) const;
+    bool writeMetrics(const QString &path) const;
+
+private:
+    struct Trace {
+        quint64 id{0};
+        QString label;                // 服务商
+        qint64 start{0};
+        qint64 stamps[StageCount]{};  // 0 表示未经过该阶段
+    };
+
+    quint64 m_nextId{1};
+    QHash<quint64, Trace> m_active;
+    QList<Trace> m_finished;            // 最近完成的 trace，用于导出
+    Histogram m_stages[StageCount];
+    QMap<QString, Histogram> m_totals;  // 各服务商的端到端耗时
+};
+
+#endif // LATENCYTRACER_H
@@ -1,10 +1,106 @@
 #include "widget.h"
+#include "batchrunner.h"
+#include "mockserver.h"
+#include "hotkeymonitor.h"
+#include "dictionarybuilder.h"
+#include "translationstore.h"
+#include "responsedecoder.h"
+#include "languagedetector.h"
+#include "translator.h"
+#include "lagprobe.h"
 #include <QApplication>
 #include <QNetworkProxyFactory>
 #include <QSharedMemory>
+#include <QTimer>
+
+// 程序是 GUI 子系统，命令行模式需要附加到启动它的控制台才能使用标准输入输出
+static void attachConsole()
+{
+#ifdef Q_OS_WIN
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONIN$", "r", stdin);
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+#endif
+}
 
 int main(int argc, char *argv[])
 {
+    // 本地模拟翻译服务，配合 --batch --bench 和 --v1-url/--v2-url 测试请求链路
+    if (MockServer::isMockMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        MockServer server;
+        if (!server.parseArguments(a.arguments()) || !server.listen()) {
+            return 1;
+        }
+        return a.exec();
+    }
+
+    // 用合成按键事件测量热键检测到 GUI 线程收到信号的延迟，不安装系统钩子
+    if (HotkeyMonitor::isBenchMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        return HotkeyMonitor::benchmark(a.arguments());
+    }
+
+    // 生成大量记录后测量翻译记录的打开和查询耗时
+    if (TranslationStore::isBenchMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        return TranslationStore::benchmark(a.arguments());
+    }
+
+    // 比较流式解码器和 QJsonDocument 解析不同大小响应的耗时和分配次数
+    if (ResponseDecoder::isBenchMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        return ResponseDecoder::benchmark(a.arguments());
+    }
+
+    // 比较 QJsonObject 和请求模板构建请求体的耗时和分配次数
+    if (Translator::isBenchMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        return Translator::benchmark(a.arguments());
+    }
+
+    // 比较文字统计的向量路径、逐字符路径和旧的汉字判断的吞吐量
+    if (LanguageDetector::isBenchMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        return LanguageDetector::benchmark(a.arguments());
+    }
+
+    // 开启和关闭请求流水线各翻译约 1 MB 文本，比较事件循环延迟
+    if (LagProbe::isBenchMode(argc, argv)) {
+        attachConsole();
+        QNetworkProxyFactory::setUseSystemConfiguration(false);
+        QCoreApplication a(argc, argv);
+        return LagProbe::benchmark(a.arguments());
+    }
+
+    // 离线词典工具：从开放词表生成词典文件，或测量查询延迟和内存占用
+    if (DictionaryBuilder::isToolMode(argc, argv)) {
+        attachConsole();
+        QCoreApplication a(argc, argv);
+        return DictionaryBuilder::run(a.arguments());
+    }
+
+    // 命令行批量翻译模式：不创建窗口、不安装键盘钩子，可在无显示环境下运行
+    if (BatchRunner::isBatchMode(argc, argv)) {
+        attachConsole();
+        QNetworkProxyFactory::setUseSystemConfiguration(false);
+        QCoreApplication a(argc, argv);
+        BatchRunner runner;
+        if (!runner.parseArguments(a.arguments())) {
+            return 1;
+        }
+        QTimer::singleShot(0, &runner, &BatchRunner::start);
+        return a.exec();
+    }
+
     //检测程序是否已经运行
     QSharedMemory singleton("translate");
     if (!singleton.create(1)) {
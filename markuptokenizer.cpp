@@ -0,0 +1,247 @@
+#include "markuptokenizer.h"
+
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+const QRegularExpression &urlPattern()
+{
+    static const QRegularExpression pattern(R"(\b(?:https?|ftp)://[^\s<>"'）」]+)");
+    return pattern;
+}
+
+bool isCodeLine(const QString &line)
+{
+    static const QRegularExpression keyword(
+        R"(^(?:#include|#define|import |from \S+ import|def |class |return\b|if\s*\(|for\s*\(|while\s*\(|public:|private:|const |let |var |function\b|fn |func |package ))");
+    if (line.endsWith(';') || line.endsWith('{') || line.endsWith('}') || line == "}" || line.endsWith("):")) {
+        return true;
+    }
+    return line.startsWith("//") || line.startsWith("/*") || keyword.match(line).hasMatch();
+}
+
+// 按语言特征判断注释语法：# 注释（Python、Shell 等）还是 // 和 /* */（C 系语言）
+bool usesHashComments(const QString &text)
+{
+    static const QRegularExpression hashLanguage(
+        R"(^[ \t]*(?:def |elif |from \S+ import |import [\w.]+[ \t]*$|#!|fi[ \t]*$|esac\b|done[ \t]*$)|\):[ \t]*$|\bself\.)",
+        QRegularExpression::MultilineOption);
+    static const QRegularExpression cLanguage(
+        R"(^[ \t]*#(?:include|define|pragma|if|ifdef|ifndef|endif)\b|[;{}][ \t]*$|(?:^|\s)//|/\*)",
+        QRegularExpression::MultilineOption);
+    int hash = 0;
+    for (auto it = hashLanguage.globalMatch(text); it.hasNext(); it.next()) {
+        ++hash;
+    }
+    int c = 0;
+    for (auto it = cLanguage.globalMatch(text); it.hasNext(); it.next()) {
+        ++c;
+    }
+    return hash > c;
+}
+}
+
+MarkupTokenizer::Format MarkupTokenizer::detect(const QString &text)
+{
+    static const QRegularExpression tag(R"(</?[a-zA-Z][a-zA-Z0-9-]*(?:\s[^<>]*)?/?>)");
+    int tags = 0;
+    for (auto it = tag.globalMatch(text); it.hasNext() && tags < 2; it.next()) {
+        ++tags;
+    }
+    if (tags >= 2 && text.contains("</")) {
+        return Html;
+    }
+
+    // 有一定比例的行以分号、花括号结尾或以关键字开头时按源代码处理
+    // 以 * 开头的行只在 /* 块注释内才算代码，否则是 Markdown 列表
+    int lines = 0;
+    int codeLines = 0;
+    bool inBlockComment = false;
+    for (QStringView line : QStringView(text).split('\n')) {
+        const QString trimmed = line.trimmed().toString();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+        ++lines;
+        if (isCodeLine(trimmed) || (inBlockComment && trimmed.startsWith('*'))) {
+            ++codeLines;
+        }
+        if (trimmed.contains("/*")) {
+            inBlockComment = true;
+        }
+        if (trimmed.contains("*/")) {
+            inBlockComment = trimmed.lastIndexOf("/*") > trimmed.lastIndexOf("*/");
+        }
+    }
+    if (lines >= 3 && codeLines * 10 >= lines * 4) {
+        return SourceCode;
+    }
+
+    static const QRegularExpression markdown(R"((?:^|\n)(?:```|#{1,6} |[ \t]*[-*+] |[ \t]*\d+\. |> )|`[^`\n]+`|\]\([^)\s]+\))");
+    if (markdown.match(text).hasMatch()) {
+        return Markdown;
+    }
+    return PlainText;
+}
+
+QList<MarkupSpan> MarkupTokenizer::tokenize(const QString &text)
+{
+    // 识别为标记或代码却找不到任何自然语言时多半是误判，按普通文本处理，避免原样返回整段
+    const Format format = detect(text);
+    QList<MarkupSpan> spans = tokenize(text, format);
+    if (format != PlainText && !hasProse(spans)) {
+        spans = tokenize(text, PlainText);
+    }
+    return spans;
+}
+
+bool MarkupTokenizer::hasProse(const QList<MarkupSpan> &spans)
+{
+    for (const MarkupSpan &span : spans) {
+        if (span.translatable) {
+            for (QChar ch : span.text) {
+                if (ch.isLetter()) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+QList<MarkupSpan> MarkupTokenizer::tokenize(const QString &text, Format format)
+{
+    QList<Range> ranges;
+    switch (format) {
+    case Html: {
+        static const QRegularExpression raw(R"(<(script|style|pre|code)\b[^>]*>.*?</\1\s*>)",
+                                            QRegularExpression::DotMatchesEverythingOption
+                                                | QRegularExpression::CaseInsensitiveOption);
+        static const QRegularExpression comment(R"(<!--.*?-->)", QRegularExpression::DotMatchesEverythingOption);
+        static const QRegularExpression tag(R"(<[^<>]+>)");
+        static const QRegularExpression entity(R"(&(?:[a-zA-Z]+|#[0-9]+|#x[0-9a-fA-F]+);)");
+        collect(text, raw, &ranges);
+        collect(text, comment, &ranges);
+        collect(text, tag, &ranges);
+        collect(text, entity, &ranges);
+        break;
+    }
+    case Markdown: {
+        static const QRegularExpression fence(R"(```.*?(?:```|$))", QRegularExpression::DotMatchesEverythingOption);
+        static const QRegularExpression inlineCode(R"(`[^`\n]+`)");
+        static const QRegularExpression linkTarget(R"(\]\([^)\n]*\)|!?\[(?=[^\]\n]*\]\())");
+        static const QRegularExpression marker(R"(^[ \t]*(?:#{1,6}|[-*+]|\d+[.)]|>)[ \t]+)",
+                                               QRegularExpression::MultilineOption);
+        static const QRegularExpression tag(R"(<[^<>\n]+>)");
+        collect(text, fence, &ranges);
+        collect(text, inlineCode, &ranges);
+        collect(text, linkTarget, &ranges);
+        collect(text, marker, &ranges);
+        collect(text, tag, &ranges);
+        break;
+    }
+    case SourceCode:
+        return build(text, codeProse(text), true);
+    case PlainText:
+        break;
+    }
+
+    collect(text, urlPattern(), &ranges);
+    return build(text, ranges, false);
+}
+
+void MarkupTokenizer::collect(const QString &text, const QRegularExpression &pattern, QList<Range> *ranges)
+{
+    for (auto it = pattern.globalMatch(text); it.hasNext();) {
+        const QRegularExpressionMatch match = it.next();
+        if (match.capturedLength() > 0) {
+            ranges->append(Range{int(match.capturedStart()), int(match.capturedEnd())});
+        }
+    }
+}
+
+QList<MarkupTokenizer::Range> MarkupTokenizer::codeProse(const QString &text)
+{
+    // 先匹配字符串字面量，避免把 "http://..." 这样的内容当成注释
+    static const QRegularExpression cStyle(R"("(?:\\.|[^"\\\n])*"|'(?:\\.|[^'\\\n])*'|//[^\n]*|/\*.*?(?:\*/|$))",
+                                           QRegularExpression::DotMatchesEverythingOption);
+    static const QRegularExpression hashStyle(R"("(?:\\.|[^"\\\n])*"|'(?:\\.|[^'\\\n])*'|#[^\n]*)");
+    const QRegularExpression &comment = usesHashComments(text) ? hashStyle : cStyle;
+
+    QList<Range> prose;
+    for (auto it = comment.globalMatch(text); it.hasNext();) {
+        const QRegularExpressionMatch match = it.next();
+        int start = int(match.capturedStart());
+        int end = int(match.capturedEnd());
+        const QChar first = text.at(start);
+        if (first == '"' || first == '\'') {
+            continue;
+        }
+
+        // 跳过注释符号（含 /// 和 /** 这样的文档注释），块注释去掉结尾的 */
+        const bool block = text.mid(start, 2) == "/*";
+        start += first == '#' ? 1 : 2;
+        while (start < end && (text.at(start) == '/' || text.at(start) == '*' || text.at(start) == '!')) {
+            ++start;
+        }
+        if (block && end - start >= 2 && text.mid(end - 2, 2) == "*/") {
+            end -= 2;
+        }
+
+        // 块注释按行拆开，每行开头的空白和 * 保持原样
+        int line = start;
+        while (line < end) {
+            int lineEnd = text.indexOf('\n', line);
+            if (lineEnd < 0 || lineEnd > end) {
+                lineEnd = end;
+            }
+            int proseStart = line;
+            while (proseStart < lineEnd && (text.at(proseStart).isSpace() || (block && text.at(proseStart) == '*'))) {
+                ++proseStart;
+            }
+            if (proseStart < lineEnd) {
+                prose.append(Range{proseStart, lineEnd});
+            }
+            line = lineEnd + 1;
+        }
+    }
+    return prose;
+}
+
+QList<MarkupSpan> MarkupTokenizer::build(const QString &text, QList<Range> ranges, bool rangesTranslatable)
+{
+    // 合并重叠的区间后，区间和区间之间的空隙交替输出
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) {
+        return a.start < b.start;
+    });
+
+    QList<MarkupSpan> spans;
+    auto append = [&spans, &text](int start, int end, bool translatable) {
+        if (end <= start) {
+            return;
+        }
+        if (!spans.isEmpty() && spans.last().translatable == translatable) {
+            spans.last().text += QStringView(text).mid(start, end - start);
+        } else {
+            spans.append(MarkupSpan{text.mid(start, end - start), translatable});
+        }
+    };
+
+    int pos = 0;
+    for (int i = 0; i < ranges.size(); ++i) {
+        Range range = ranges.at(i);
+        if (range.end <= pos) {
+            continue;
+        }
+        range.start = qMax(range.start, pos);
+        // 吸收与之重叠的后续区间
+        while (i + 1 < ranges.size() && ranges.at(i + 1).start < range.end) {
+            range.end = qMax(range.end, ranges.at(++i).end);
+        }
+        append(pos, range.start, !rangesTranslatable);
+        append(range.start, range.end, rangesTranslatable);
+        pos = range.end;
+    }
+    append(pos, text.size(), !rangesTranslatable);
+    return spans;
+}
@@ -0,0 +1,45 @@
+#ifndef MARKUPTOKENIZER_H
+#define MARKUPTOKENIZER_H
+
+#include <QList>
+#include <QString>
+
+class QRegularExpression;
+
+// 标记或代码中的一段，只有 translatable 的片段需要发送翻译
+struct MarkupSpan
+{
+    QString text;
+    bool translatable{true};
+};
+
+// 识别 HTML、Markdown 和源代码，把标签、网址、代码等结构与自然语言分开，
+// 翻译后按原顺序拼回即可保持结构不变
+class MarkupTokenizer
+{
+public:
+    enum Format {
+        PlainText,
+        Html,
+        Markdown,
+        SourceCode     // 只翻译注释
+    };
+
+    static Format detect(const QString &text);
+    static QList<MarkupSpan> tokenize(const QString &text, Format format);
+    // 自动识别格式；识别结果中没有自然语言时按普通文本处理
+    static QList<MarkupSpan> tokenize(const QString &text);
+
+private:
+    struct Range {
+        int start;
+        int end;
+    };
+
+    static bool hasProse(const QList<MarkupSpan> &spans);
+    static void collect(const QString &text, const QRegularExpression &pattern, QList<Range> *ranges);
+    static QList<Range> codeProse(const QString &text);
+    static QList<MarkupSpan> build(const QString &text, QList<Range> ranges, bool rangesTranslatable);
+};
+
+#endif // MARKUPTOKENIZER_H
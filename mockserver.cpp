@@ -0,0 +1,538 @@
+#include "mockserver.h"
+#include "bodycodec.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSslCertificate>
+#include <QSslConfiguration>
+#include <QSslKey>
+#include <QTcpSocket>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
+#include <QSslServer>
+#endif
+#include <QTimer>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const QByteArray kHttp2Preface = QByteArrayLiteral("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+const int kHttp2MaxFrameSize = 16384;
+
+enum Http2FrameType : quint8 {
+    FrameData = 0x0,
+    FrameHeaders = 0x1,
+    FrameRstStream = 0x3,
+    FrameSettings = 0x4,
+    FramePing = 0x6,
+    FrameGoAway = 0x7,
+    FrameWindowUpdate = 0x8
+};
+
+enum Http2Flag : quint8 {
+    FlagEndStream = 0x1,
+    FlagAck = 0x1,
+    FlagEndHeaders = 0x4,
+    FlagPadded = 0x8
+};
+
+QByteArray http2Frame(quint8 type, quint8 flags, quint32 streamId, const QByteArray &payload = {})
+{
+    QByteArray frame(9, Qt::Uninitialized);
+    uchar *head = reinterpret_cast<uchar *>(frame.data());
+    head[0] = uchar(payload.size() >> 16);
+    head[1] = uchar(payload.size() >> 8);
+    head[2] = uchar(payload.size());
+    head[3] = type;
+    head[4] = flags;
+    qToBigEndian(streamId & 0x7fffffff, head + 5);
+    return frame + payload;
+}
+
+QByteArray windowUpdate(quint32 streamId, quint32 increment)
+{
+    QByteArray payload(4, Qt::Uninitialized);
+    qToBigEndian(increment, payload.data());
+    return http2Frame(FrameWindowUpdate, 0, streamId, payload);
+}
+
+// HPACK：静态表中的名称 + 不加索引的字面值，不用 Huffman，值长度都小于 127
+QByteArray hpackLiteral(int nameIndex, const QByteArray &value)
+{
+    QByteArray field;
+    if (nameIndex < 15) {
+        field += char(nameIndex);
+    } else {
+        field += char(0x0f);
+        field += char(nameIndex - 15);
+    }
+    field += char(value.size());
+    return field + value;
+}
+
+} // namespace
+
+MockServer::MockServer(QObject *parent)
+    : QObject{parent}
+{
+}
+
+bool MockServer::isMockMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--mock-server") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MockServer::parseArguments(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the Volcengine and Tencent translation APIs.");
+    parser.addHelpOption();
+    QCommandLineOption mockOption("mock-server", "Run the mock translation server.");
+    QCommandLineOption portOption("port", "Listen port.", "port", "8080");
+    QCommandLineOption latencyOption("latency", "Fixed response latency in ms.", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Random extra latency up to ms.", "ms", "0");
+    QCommandLineOption errorOption("error-rate", "Fraction of provider error responses.", "rate", "0");
+    QCommandLineOption httpErrorOption("http-error-rate", "Fraction of HTTP 503 responses.", "rate", "0");
+    QCommandLineOption timeoutOption("timeout-rate", "Fraction of requests never answered.", "rate", "0");
+    QCommandLineOption dripBytesOption("drip-bytes", "Send the body in pieces of this many bytes.", "n", "0");
+    QCommandLineOption dripIntervalOption("drip-interval", "Delay between body pieces in ms.", "ms", "50");
+    QCommandLineOption tlsCertOption("tls-cert", "PEM certificate; serve HTTPS when set.", "file");
+    QCommandLineOption tlsKeyOption("tls-key", "PEM private key for --tls-cert.", "file");
+    QCommandLineOption tls12Option("tls12", "Restrict HTTPS to TLS 1.2.");
+    QCommandLineOption gzipOption("gzip", "Gzip responses for clients that accept it.");
+    QCommandLineOption h2Option("h2", "Offer HTTP/2: h2 over ALPN with --tls-cert, prior-knowledge h2c otherwise.");
+    parser.addOptions({mockOption, portOption, latencyOption, jitterOption, errorOption,
+                       httpErrorOption, timeoutOption, dripBytesOption, dripIntervalOption,
+                       tlsCertOption, tlsKeyOption, tls12Option, gzipOption, h2Option});
+    parser.process(arguments);
+
+    m_port = quint16(parser.value(portOption).toUInt());
+    m_latency = qMax(0, parser.value(latencyOption).toInt());
+    m_jitter = qMax(0, parser.value(jitterOption).toInt());
+    m_errorRate = parser.value(errorOption).toDouble();
+    m_httpErrorRate = parser.value(httpErrorOption).toDouble();
+    m_timeoutRate = parser.value(timeoutOption).toDouble();
+    m_dripBytes = qMax(0, parser.value(dripBytesOption).toInt());
+    m_dripInterval = qMax(0, parser.value(dripIntervalOption).toInt());
+    m_tlsCert = parser.value(tlsCertOption);
+    m_tlsKey = parser.value(tlsKeyOption);
+    m_tls12 = parser.isSet(tls12Option);
+    m_gzip = parser.isSet(gzipOption);
+    m_http2 = parser.isSet(h2Option);
+    if (m_gzip && !BodyCodec::isAvailable()) {
+        qWarning() << "Built without zlib, --gzip is ignored";
+    }
+    return true;
+}
+
+bool MockServer::listen()
+{
+    if (!m_tlsCert.isEmpty()) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
+        QFile certFile(m_tlsCert);
+        QFile keyFile(m_tlsKey);
+        if (!certFile.open(QIODevice::ReadOnly) || !keyFile.open(QIODevice::ReadOnly)) {
+            qCritical() << "Failed to read TLS certificate or key";
+            return false;
+        }
+
+        QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+        config.setLocalCertificate(QSslCertificate(&certFile, QSsl::Pem));
+        config.setPrivateKey(QSslKey(&keyFile, QSsl::Rsa, QSsl::Pem));
+        config.setPeerVerifyMode(QSslSocket::VerifyNone);
+        config.setProtocol(m_tls12 ? QSsl::TlsV1_2 : QSsl::TlsV1_2OrLater);
+        // 未开启 --h2 时只通过 ALPN 提供 HTTP/1.1，客户端即使请求 h2 也会退回 HTTP/1.1
+        if (m_http2) {
+            config.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        } else {
+            config.setAllowedNextProtocols({QSslConfiguration::NextProtocolHttp1_1});
+        }
+
+        QSslServer *server = new QSslServer(this);
+        server->setSslConfiguration(config);
+        m_server = server;
+#else
+        qCritical() << "HTTPS mock server requires Qt 6.4 or later";
+        return false;
+#endif
+    } else {
+        m_server = new QTcpServer(this);
+    }
+    connect(m_server, &QTcpServer::newConnection, this, &MockServer::newConnection);
+
+    if (!m_server->listen(QHostAddress::LocalHost, m_port)) {
+        qCritical() << "Mock server failed to listen on port" << m_port << m_server->errorString();
+        return false;
+    }
+    qInfo() << "Mock translation server listening on"
+            << QString("%1://127.0.0.1:%2").arg(m_tlsCert.isEmpty() ? "http" : "https").arg(m_server->serverPort())
+            << (m_http2 ? (m_tlsCert.isEmpty() ? "(HTTP/1.1, h2c prior knowledge)" : "(h2, HTTP/1.1)") : "(HTTP/1.1)");
+    qInfo() << "  volcengine: /crx/translate/v2/   tencent: /api/imt";
+    return true;
+}
+
+bool MockServer::chance(double rate) const
+{
+    return rate > 0 && QRandomGenerator::global()->generateDouble() < rate;
+}
+
+void MockServer::newConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, &MockServer::readClient);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockServer::readClient()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket) {
+        return;
+    }
+
+    Connection &connection = m_connections[socket];
+    QByteArray &buffer = connection.buffer;
+    buffer += socket->readAll();
+
+    // HTTP/2 连接以固定的前言开头（ALPN 协商为 h2 之后，或明文 prior knowledge）
+    if (m_http2 && !connection.http2 && buffer.size() < kHttp2Preface.size()
+        && kHttp2Preface.startsWith(buffer)) {
+        return;
+    }
+    if (m_http2 && !connection.http2 && buffer.startsWith(kHttp2Preface)) {
+        connection.http2 = true;
+        buffer.remove(0, kHttp2Preface.size());
+        // SETTINGS_MAX_CONCURRENT_STREAMS = 100
+        socket->write(http2Frame(FrameSettings, 0, 0, QByteArray::fromHex("000300000064")));
+    }
+    if (connection.http2) {
+        readHttp2(socket, connection);
+        return;
+    }
+
+    // 同一连接上可能连续发送多个请求（keep-alive）
+    forever {
+        const int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        qsizetype contentLength = 0;
+        QByteArray contentEncoding;
+        bool acceptGzip = false;
+        for (const QByteArray &line : lines) {
+            const int colon = line.indexOf(':');
+            if (colon <= 0) {
+                continue;
+            }
+            const QByteArray name = line.left(colon).trimmed().toLower();
+            const QByteArray value = line.mid(colon + 1).trimmed();
+            if (name == "content-length") {
+                contentLength = value.toLongLong();
+            } else if (name == "content-encoding") {
+                contentEncoding = value;
+            } else if (name == "accept-encoding") {
+                acceptGzip = value.toLower().contains("gzip");
+            }
+        }
+
+        const qsizetype total = headerEnd + 4 + contentLength;
+        if (buffer.size() < total) {
+            return;
+        }
+
+        const QByteArray path = requestLine.size() > 1 ? requestLine.at(1) : QByteArray("/");
+        QByteArray body = buffer.mid(headerEnd + 4, contentLength);
+        buffer.remove(0, total);
+
+        // 接受压缩的请求体，按客户端声明的编码压缩响应
+        if (!contentEncoding.isEmpty()) {
+            BodyCodec codec(BodyCodec::parseEncoding(contentEncoding));
+            body = codec.decode(body);
+        }
+        Response response = handle(path, body);
+        if (response.hang) {
+            continue;
+        }
+        if (m_gzip && acceptGzip && BodyCodec::isAvailable()) {
+            response.body = BodyCodec::gzip(response.body);
+            response.gzip = true;
+        }
+
+        dispatch(socket, 0, response);
+    }
+}
+
+void MockServer::readHttp2(QTcpSocket *socket, Connection &connection)
+{
+    QByteArray &buffer = connection.buffer;
+    forever {
+        if (buffer.size() < 9) {
+            return;
+        }
+        const uchar *head = reinterpret_cast<const uchar *>(buffer.constData());
+        const int length = (head[0] << 16) | (head[1] << 8) | head[2];
+        if (buffer.size() < 9 + length) {
+            return;
+        }
+        const quint8 type = head[3];
+        const quint8 flags = head[4];
+        const quint32 streamId = qFromBigEndian<quint32>(head + 5) & 0x7fffffff;
+        const QByteArray payload = buffer.mid(9, length);
+        buffer.remove(0, 9 + length);
+
+        switch (type) {
+        case FrameSettings:
+            if (!(flags & FlagAck)) {
+                socket->write(http2Frame(FrameSettings, FlagAck, 0));
+            }
+            break;
+        case FramePing:
+            if (!(flags & FlagAck)) {
+                socket->write(http2Frame(FramePing, FlagAck, 0, payload));
+            }
+            break;
+        case FrameHeaders:
+            // 不解码 HPACK：路由和编码由请求体判断，见 finishStream
+            connection.streams.insert(streamId, QByteArray());
+            if (flags & FlagEndStream) {
+                finishStream(socket, connection, streamId);
+            }
+            break;
+        case FrameData: {
+            if (!connection.streams.contains(streamId)) {
+                break;
+            }
+            int padding = 0;
+            if ((flags & FlagPadded) && length > 0) {
+                padding = 1 + quint8(payload.at(0));
+            }
+            connection.streams[streamId] += payload.mid(flags & FlagPadded ? 1 : 0, length - padding);
+            // 立即归还流控窗口，否则并发请求体超过默认 64KB 窗口后客户端会停止发送
+            if (length > 0) {
+                socket->write(windowUpdate(0, quint32(length)));
+                if (!(flags & FlagEndStream)) {
+                    socket->write(windowUpdate(streamId, quint32(length)));
+                }
+            }
+            if (flags & FlagEndStream) {
+                finishStream(socket, connection, streamId);
+            }
+            break;
+        }
+        case FrameRstStream:
+            connection.streams.remove(streamId);
+            connection.pending.remove(streamId);
+            break;
+        case FrameGoAway:
+            socket->disconnectFromHost();
+            return;
+        default:
+            // PRIORITY、WINDOW_UPDATE、CONTINUATION 等：响应很小，不需要处理
+            break;
+        }
+    }
+}
+
+void MockServer::finishStream(QTcpSocket *socket, Connection &connection, quint32 streamId)
+{
+    QByteArray body = connection.streams.take(streamId);
+    // 没有解码请求头，按 gzip 魔数识别压缩的请求体；h2 响应不压缩
+    if (body.startsWith("\x1f\x8b")) {
+        BodyCodec codec(BodyCodec::Gzip);
+        body = codec.decode(body);
+    }
+    // 按请求体结构区分服务商：腾讯的文本在 source 对象里
+    const QByteArray path = QJsonDocument::fromJson(body).object().contains("source")
+                                ? QByteArray("/api/imt")
+                                : QByteArray("/crx/translate/v2/");
+    const Response response = handle(path, body);
+    if (response.hang) {
+        return;
+    }
+    connection.pending.insert(streamId);
+    dispatch(socket, streamId, response);
+}
+
+void MockServer::dispatch(QTcpSocket *socket, quint32 streamId, const Response &response)
+{
+    int delay = m_latency;
+    if (m_jitter > 0) {
+        delay += QRandomGenerator::global()->bounded(m_jitter + 1);
+    }
+
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(delay, this, [this, guard, streamId, response]() {
+        if (guard) {
+            sendResponse(guard, streamId, response);
+        }
+    });
+}
+
+bool MockServer::isStreamOpen(QTcpSocket *socket, quint32 streamId) const
+{
+    if (streamId == 0) {
+        return true;
+    }
+    const auto it = m_connections.constFind(socket);
+    return it != m_connections.constEnd() && it->pending.contains(streamId);
+}
+
+MockServer::Response MockServer::handle(const QByteArray &path, const QByteArray &body)
+{
+    Response response;
+    if (chance(m_timeoutRate)) {
+        response.hang = true;
+        return response;
+    }
+    if (chance(m_httpErrorRate)) {
+        response.status = 503;
+        response.body = "Service Unavailable";
+        return response;
+    }
+
+    const QJsonObject request = QJsonDocument::fromJson(body).object();
+    const bool fail = chance(m_errorRate);
+    if (path.startsWith("/crx/translate")) {
+        response.body = translateVolcengine(request, fail);
+    } else if (path.startsWith("/api/imt")) {
+        response.body = translateTencent(request, fail);
+    } else {
+        response.status = 404;
+        response.body = "Not Found";
+    }
+    return response;
+}
+
+QByteArray MockServer::translateVolcengine(const QJsonObject &request, bool fail)
+{
+    QJsonObject baseResp;
+    QJsonArray translations;
+    if (fail) {
+        baseResp["status_code"] = 1001;
+        baseResp["status_message"] = "mock error";
+    } else {
+        baseResp["status_code"] = 0;
+        baseResp["status_message"] = "";
+        const QString prefix = "[" + request["target_language"].toString() + "] ";
+        for (const QJsonValue &value : request["text_list"].toArray()) {
+            const QString text = value.toString();
+            translations.append(text.isEmpty() ? text : prefix + text);
+        }
+    }
+
+    QJsonObject json;
+    json["translations"] = translations;
+    json["base_resp"] = baseResp;
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+QByteArray MockServer::translateTencent(const QJsonObject &request, bool fail)
+{
+    QJsonObject header;
+    header["ret_code"] = fail ? "error" : "succ";
+
+    QJsonObject json;
+    json["header"] = header;
+    if (!fail) {
+        const QString prefix = "[" + request["target"].toObject()["lang"].toString() + "] ";
+        QJsonArray translations;
+        for (const QJsonValue &value : request["source"].toObject()["text_list"].toArray()) {
+            translations.append(prefix + value.toString());
+        }
+        json["auto_translation"] = translations;
+    }
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+void MockServer::sendResponse(QTcpSocket *socket, quint32 streamId, const Response &response)
+{
+    if (streamId != 0) {
+        if (!isStreamOpen(socket, streamId)) {
+            return;
+        }
+        QByteArray block = response.status == 200 ? QByteArray(1, char(0x88))  // :status 200 的静态表索引
+                                                  : hpackLiteral(8, QByteArray::number(response.status));
+        block += hpackLiteral(31, "application/json");
+        block += hpackLiteral(28, QByteArray::number(response.body.size()));
+        const bool empty = response.body.isEmpty();
+        socket->write(http2Frame(FrameHeaders, quint8(FlagEndHeaders | (empty ? FlagEndStream : 0)), streamId, block));
+        if (empty) {
+            m_connections[socket].pending.remove(streamId);
+        } else if (m_dripBytes <= 0) {
+            writeData(socket, streamId, response.body, true);
+        } else {
+            drip(socket, streamId, response.body, 0);
+        }
+        return;
+    }
+
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status)
+                      + (response.status == 200 ? " OK" : " Error") + "\r\n"
+                      + "Content-Type: application/json\r\n"
+                      + (response.gzip ? "Content-Encoding: gzip\r\n" : "")
+                      + "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n"
+                      + "Connection: keep-alive\r\n\r\n";
+
+    if (m_dripBytes <= 0) {
+        socket->write(head + response.body);
+        return;
+    }
+
+    // 慢速返回：先写响应头，再按固定间隔分段写出正文
+    socket->write(head);
+    drip(socket, 0, response.body, 0);
+}
+
+void MockServer::drip(QTcpSocket *socket, quint32 streamId, const QByteArray &data, int offset)
+{
+    if (!isStreamOpen(socket, streamId)) {
+        return;
+    }
+    const int next = offset + m_dripBytes;
+    if (streamId != 0) {
+        writeData(socket, streamId, data.mid(offset, m_dripBytes), next >= data.size());
+    } else {
+        socket->write(data.mid(offset, m_dripBytes));
+    }
+    if (next >= data.size()) {
+        return;
+    }
+
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(m_dripInterval, this, [this, guard, streamId, data, next]() {
+        if (guard) {
+            drip(guard, streamId, data, next);
+        }
+    });
+}
+
+void MockServer::writeData(QTcpSocket *socket, quint32 streamId, const QByteArray &data, bool endStream)
+{
+    // 响应远小于客户端的默认接收窗口，不做发送端流控，只按最大帧长度切分
+    for (qsizetype offset = 0; offset < data.size(); offset += kHttp2MaxFrameSize) {
+        const bool last = offset + kHttp2MaxFrameSize >= data.size();
+        socket->write(http2Frame(FrameData, quint8(last && endStream ? FlagEndStream : 0), streamId,
+                                 data.mid(offset, kHttp2MaxFrameSize)));
+    }
+    if (endStream) {
+        m_connections[socket].pending.remove(streamId);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef MOCKSERVER_H
+#define MOCKSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+// 本地模拟翻译服务，同时支持火山翻译（translations/base_resp）和
+// 腾讯翻译（header.ret_code/auto_translation）两种格式，
+// 可注入延迟、错误、超时和慢速分段返回，用于测试和压测请求链路。
+// 开启 --h2 时还实现了最小的 HTTP/2 服务端（HTTPS 上经 ALPN 协商，明文上接受 prior knowledge），
+// 用来对比多路复用与 HTTP/1.1 的连接数和尾延迟。
+class MockServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MockServer(QObject *parent = nullptr);
+
+    static bool isMockMode(int argc, char *argv[]);
+    bool parseArguments(const QStringList &arguments);
+    bool listen();
+    quint16 serverPort() const { return m_server ? m_server->serverPort() : 0; }
+
+private slots:
+    void newConnection();
+    void readClient();
+
+private:
+    struct Response {
+        int status{200};
+        QByteArray body;
+        bool hang{false};  // 不返回，模拟超时
+        bool gzip{false};
+    };
+
+    // 每个连接的状态
+    struct Connection {
+        QByteArray buffer;                // 未处理完的请求数据
+        bool http2{false};
+        QHash<quint32, QByteArray> streams;  // 已收到请求头、正文未收完的流
+        QSet<quint32> pending;               // 等待响应且未被客户端取消的流
+    };
+
+    void readHttp2(QTcpSocket *socket, Connection &connection);
+    void finishStream(QTcpSocket *socket, Connection &connection, quint32 streamId);
+    void dispatch(QTcpSocket *socket, quint32 streamId, const Response &response);
+    Response handle(const QByteArray &path, const QByteArray &body);
+    QByteArray translateVolcengine(const QJsonObject &request, bool fail);
+    QByteArray translateTencent(const QJsonObject &request, bool fail);
+    void sendResponse(QTcpSocket *socket, quint32 streamId, const Response &response);
+    void drip(QTcpSocket *socket, quint32 streamId, const QByteArray &data, int offset);
+    void writeData(QTcpSocket *socket, quint32 streamId, const QByteArray &data, bool endStream);
+    bool isStreamOpen(QTcpSocket *socket, quint32 streamId) const;
+    bool chance(double rate) const;
+
+    QTcpServer *m_server{nullptr};  // 配置证书时为 QSslServer
+    QHash<QTcpSocket *, Connection> m_connections;
+
+    quint16 m_port{8080};
+    int m_latency{0};          // 固定延迟（毫秒）
+    int m_jitter{0};           // 随机附加延迟上限（毫秒）
+    double m_errorRate{0};     // 返回服务商错误码的比例
+    double m_httpErrorRate{0}; // 返回 HTTP 503 的比例
+    double m_timeoutRate{0};   // 不返回的比例
+    int m_dripBytes{0};        // 慢速返回时每次写出的字节数，0 表示一次写完
+    int m_dripInterval{50};    // 慢速返回的间隔（毫秒）
+    QString m_tlsCert;         // PEM 证书，配置后以 HTTPS 提供服务
+    QString m_tlsKey;
+    bool m_tls12{false};       // 仅使用 TLS 1.2，便于观察会话恢复
+    bool m_gzip{false};        // 客户端接受时以 gzip 返回
+    bool m_http2{false};       // 提供 HTTP/2
+};
+
+#endif // MOCKSERVER_H
@@ -0,0 +1,303 @@
+#include "offlinedictionary.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QList>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const char kFileMagic[8] = {'T', 'R', 'D', 'I', 'C', 'T', '1', '\0'};
+const qint64 kHeaderSize = 24;
+const quint32 kNoValue = 0xFFFFFFFF;
+const int kMaxQueryLength = 48;
+const int kMaxQueryWords = 4;
+
+qint64 align4(qint64 offset)
+{
+    return (offset + 3) & ~qint64(3);
+}
+
+void append32(QByteArray *data, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian(value, bytes);
+    data->append(reinterpret_cast<const char *>(bytes), 4);
+}
+}
+
+OfflineDictionary::~OfflineDictionary()
+{
+    close();
+}
+
+QString OfflineDictionary::defaultPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/dictionary.dat";
+}
+
+bool OfflineDictionary::open(const QString &path)
+{
+    close();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_file.setFileName(path);
+    if (!m_file.exists()) {
+        return false;
+    }
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open dictionary:" << path << m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_map = m_size >= kHeaderSize ? m_file.map(0, m_size) : nullptr;
+    if (!m_map || std::memcmp(m_map, kFileMagic, sizeof(kFileMagic)) != 0) {
+        qWarning() << "Invalid dictionary file:" << path;
+        close();
+        return false;
+    }
+
+    m_nodeCount = read32(8);
+    m_edgeCount = read32(12);
+    m_entryCount = read32(16);
+    m_poolSize = read32(20);
+    m_nodes = kHeaderSize;
+    m_labels = m_nodes + qint64(m_nodeCount) * 8;
+    m_targets = align4(m_labels + qint64(m_edgeCount) * 2);
+    m_pool = m_targets + qint64(m_edgeCount) * 4;
+    if (m_nodeCount < 2 || m_pool + m_poolSize > m_size) {
+        qWarning() << "Truncated dictionary file:" << path;
+        close();
+        return false;
+    }
+
+    m_openNsecs = timer.nsecsElapsed();
+    return true;
+}
+
+void OfflineDictionary::close()
+{
+    if (m_map) {
+        m_file.unmap(const_cast<uchar *>(m_map));
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_size = 0;
+    m_nodeCount = m_edgeCount = m_entryCount = m_poolSize = 0;
+}
+
+quint32 OfflineDictionary::read32(qint64 offset) const
+{
+    return qFromLittleEndian<quint32>(m_map + offset);
+}
+
+bool OfflineDictionary::isShortQuery(QStringView text)
+{
+    if (text.isEmpty() || text.size() > kMaxQueryLength || text.contains('\n')) {
+        return false;
+    }
+    int words = 1;
+    for (QChar ch : text) {
+        if (ch == ' ' && ++words > kMaxQueryWords) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString OfflineDictionary::normalize(QStringView text)
+{
+    // 去掉复制时带上的首尾标点和引号，保留词内的连字符、撇号和点（如 e.g.）
+    qsizetype start = 0;
+    qsizetype end = text.size();
+    while (start < end && (text.at(start).isSpace() || text.at(start).isPunct())) {
+        ++start;
+    }
+    while (end > start && (text.at(end - 1).isSpace() || (text.at(end - 1).isPunct() && text.at(end - 1) != '.'))) {
+        --end;
+    }
+    if (end - start > 1 && text.at(end - 1) == '.' && !text.mid(start, end - start - 1).contains('.')) {
+        --end;  // 句末的点，而不是缩写中的点
+    }
+    return text.mid(start, end - start).toString().toLower().simplified();
+}
+
+bool OfflineDictionary::lookup(QStringView text, QString *result)
+{
+    if (!m_map || !isShortQuery(text)) {
+        return false;
+    }
+    const QString key = normalize(text);
+    if (!key.isEmpty() && findKey(key, result)) {
+        ++m_hits;
+        return true;
+    }
+    ++m_misses;
+    return false;
+}
+
+bool OfflineDictionary::findKey(QStringView key, QString *result) const
+{
+    // 逐字符在当前节点的出边中二分查找
+    quint32 node = 0;
+    for (QChar ch : key) {
+        const quint16 label = ch.unicode();
+        quint32 lo = read32(m_nodes + qint64(node) * 8);
+        const quint32 end = read32(m_nodes + qint64(node + 1) * 8);
+        if (end > m_edgeCount || lo > end) {
+            return false;
+        }
+        quint32 hi = end;
+        while (lo < hi) {
+            const quint32 mid = (lo + hi) / 2;
+            if (qFromLittleEndian<quint16>(m_map + m_labels + qint64(mid) * 2) < label) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == end || qFromLittleEndian<quint16>(m_map + m_labels + qint64(lo) * 2) != label) {
+            return false;
+        }
+        node = read32(m_targets + qint64(lo) * 4);
+        if (node + 1 >= m_nodeCount) {
+            return false;
+        }
+    }
+
+    const quint32 value = read32(m_nodes + qint64(node) * 8 + 4);
+    if (value == kNoValue || qint64(value) + 4 > m_poolSize) {
+        return false;
+    }
+    const quint32 length = read32(m_pool + value);
+    if (qint64(value) + 4 + length > m_poolSize) {
+        return false;
+    }
+    if (result) {
+        *result = QString::fromUtf8(reinterpret_cast<const char *>(m_map + m_pool + value + 4), length);
+    }
+    return true;
+}
+
+QString OfflineDictionary::summary() const
+{
+    if (!m_map) {
+        return QString();
+    }
+    return QString("离线词典: %1 词条, %2 MB, 打开 %3 us, 命中 %4 / 查询 %5")
+        .arg(m_entryCount)
+        .arg(m_size / 1048576.0, 0, 'f', 1)
+        .arg(m_openNsecs / 1000.0, 0, 'f', 0)
+        .arg(m_hits)
+        .arg(m_hits + m_misses);
+}
+
+QString OfflineDictionary::sampleKey(QRandomGenerator *random) const
+{
+    if (!m_map || m_entryCount == 0) {
+        return QString();
+    }
+    QString key;
+    quint32 node = 0;
+    for (;;) {
+        const quint32 first = read32(m_nodes + qint64(node) * 8);
+        const quint32 last = read32(m_nodes + qint64(node + 1) * 8);
+        const bool hasValue = read32(m_nodes + qint64(node) * 8 + 4) != kNoValue;
+        if (hasValue && (first == last || random->bounded(3) == 0)) {
+            return key;
+        }
+        if (first == last) {
+            return QString();
+        }
+        const quint32 edge = first + random->bounded(last - first);
+        key.append(QChar(qFromLittleEndian<quint16>(m_map + m_labels + qint64(edge) * 2)));
+        node = read32(m_targets + qint64(edge) * 4);
+    }
+}
+
+bool OfflineDictionary::write(const QMap<QString, QString> &entries, const QString &path)
+{
+    const QList<QString> keys = entries.keys();
+
+    // 按层序展开字典树：队列中的第 i 项就是节点 i，对应有序键中共享前 depth 个字符的区间
+    struct Range {
+        qsizetype lo;
+        qsizetype hi;
+        qsizetype depth;
+    };
+    QList<Range> queue{{0, keys.size(), 0}};
+    QList<quint32> firstEdges;
+    QList<quint32> values;
+    QList<quint16> labels;
+    QList<quint32> targets;
+    QByteArray pool;
+
+    for (qsizetype i = 0; i < queue.size(); ++i) {
+        const Range range = queue.at(i);
+        firstEdges.append(quint32(labels.size()));
+
+        // 有序排列时恰好在此结束的键排在区间最前
+        qsizetype lo = range.lo;
+        quint32 value = kNoValue;
+        if (lo < range.hi && keys.at(lo).size() == range.depth) {
+            const QByteArray text = entries.value(keys.at(lo)).toUtf8();
+            value = quint32(pool.size());
+            append32(&pool, quint32(text.size()));
+            pool.append(text);
+            ++lo;
+        }
+        values.append(value);
+
+        while (lo < range.hi) {
+            const QChar ch = keys.at(lo).at(range.depth);
+            qsizetype next = lo + 1;
+            while (next < range.hi && keys.at(next).at(range.depth) == ch) {
+                ++next;
+            }
+            labels.append(ch.unicode());
+            targets.append(quint32(queue.size()));
+            queue.append({lo, next, range.depth + 1});
+            lo = next;
+        }
+    }
+    // 哨兵节点，给最后一个节点的出边范围定界
+    firstEdges.append(quint32(labels.size()));
+    values.append(kNoValue);
+
+    QByteArray data(kFileMagic, sizeof(kFileMagic));
+    append32(&data, quint32(firstEdges.size()));
+    append32(&data, quint32(labels.size()));
+    append32(&data, quint32(keys.size()));
+    append32(&data, quint32(pool.size()));
+    for (qsizetype i = 0; i < firstEdges.size(); ++i) {
+        append32(&data, firstEdges.at(i));
+        append32(&data, values.at(i));
+    }
+    for (quint16 label : std::as_const(labels)) {
+        uchar bytes[2];
+        qToLittleEndian(label, bytes);
+        data.append(reinterpret_cast<const char *>(bytes), 2);
+    }
+    data.append(QByteArray(align4(data.size()) - data.size(), '\0'));
+    for (quint32 target : std::as_const(targets)) {
+        append32(&data, target);
+    }
+    data.append(pool);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Failed to write dictionary:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
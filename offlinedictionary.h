@@ -0,0 +1,68 @@
+#ifndef OFFLINEDICTIONARY_H
+#define OFFLINEDICTIONARY_H
+
+#include <QFile>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringView>
+
+// 离线词典：只读的内存映射字典树，单词和短语无需网络即可在微秒级查到释义。
+// 文件由 DictionaryBuilder 生成，格式为：
+//   文件头  "TRDICT1\0"、节点数、边数、词条数、释义区大小（均为小端 quint32）
+//   节点    每个节点 {首条边序号, 释义偏移}，按层序排列，末尾有一个哨兵节点；
+//           节点 i 的出边为 [node[i].firstEdge, node[i + 1].firstEdge)
+//   边      按节点分组、组内按字符排序的 UTF-16 字符数组和目标节点数组，查找时二分
+//   释义区  每条释义为长度（quint32）加 UTF-8 文本
+class OfflineDictionary
+{
+public:
+    OfflineDictionary() = default;
+    ~OfflineDictionary();
+    OfflineDictionary(const OfflineDictionary &) = delete;
+    OfflineDictionary &operator=(const OfflineDictionary &) = delete;
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+
+    // 只查询单词或短语，text 先经过 normalize
+    bool lookup(QStringView text, QString *result);
+
+    int count() const { return int(m_entryCount); }
+    qint64 fileSize() const { return m_file.size(); }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    qint64 openNsecs() const { return m_openNsecs; }  // 最近一次 open 映射并校验文件的耗时
+    QString summary() const;
+    // 从根节点随机走到某个词条，供基准测试抽取命中查询
+    QString sampleKey(QRandomGenerator *random) const;
+
+    static bool isShortQuery(QStringView text);
+    // 小写、合并空白并去掉首尾标点，建库和查询使用同一规则
+    static QString normalize(QStringView text);
+    // 把词条写成上述格式，键应已 normalize
+    static bool write(const QMap<QString, QString> &entries, const QString &path);
+    static QString defaultPath();
+
+private:
+    bool findKey(QStringView key, QString *result) const;
+    quint32 read32(qint64 offset) const;
+
+    QFile m_file;
+    const uchar *m_map{nullptr};
+    qint64 m_size{0};
+    quint32 m_nodeCount{0};
+    quint32 m_edgeCount{0};
+    quint32 m_entryCount{0};
+    quint32 m_poolSize{0};
+    qint64 m_nodes{0};    // 各区在文件中的偏移
+    qint64 m_labels{0};
+    qint64 m_targets{0};
+    qint64 m_pool{0};
+    quint64 m_hits{0};
+    quint64 m_misses{0};
+    qint64 m_openNsecs{0};
+};
+
+#endif // OFFLINEDICTIONARY_H
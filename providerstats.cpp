@@ -0,0 +1,101 @@
+#include "providerstats.h"
+
+#include <algorithm>
+
+namespace {
+const int kLatencyWindow = 100;      // 延迟样本数
+const int kOutcomeWindow = 20;       // 计算错误率的请求数
+const double kEwmaAlpha = 0.2;
+const double kUnhealthyErrorRate = 0.5;
+const qint64 kRecoveryInterval = 60 * 1000;  // 不健康的服务商在此时间后重新尝试
+const int kMinTimeout = 3000;
+}
+
+void ProviderStats::recordSuccess(qint64 ms)
+{
+    m_latencies.append(ms);
+    if (m_latencies.size() > kLatencyWindow) {
+        m_latencies.removeFirst();
+    }
+    m_ewma = m_latencies.size() == 1 ? ms : kEwmaAlpha * ms + (1 - kEwmaAlpha) * m_ewma;
+    recordOutcome(Success);
+}
+
+void ProviderStats::recordError()
+{
+    m_lastFailure.start();
+    recordOutcome(Error);
+}
+
+void ProviderStats::recordTimeout()
+{
+    m_lastFailure.start();
+    recordOutcome(Timeout);
+}
+
+void ProviderStats::recordOutcome(Outcome outcome)
+{
+    m_outcomes.append(outcome);
+    if (m_outcomes.size() > kOutcomeWindow) {
+        m_outcomes.removeFirst();
+    }
+}
+
+qint64 ProviderStats::percentile(double p) const
+{
+    if (m_latencies.isEmpty()) {
+        return 0;
+    }
+
+    QList<qint64> samples = m_latencies;
+    const int rank = qBound(0, int(samples.size() * p), samples.size() - 1);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples.at(rank);
+}
+
+double ProviderStats::errorRate() const
+{
+    if (m_outcomes.isEmpty()) {
+        return 0;
+    }
+    return double(m_outcomes.size() - m_outcomes.count(Success)) / m_outcomes.size();
+}
+
+double ProviderStats::timeoutRate() const
+{
+    if (m_outcomes.isEmpty()) {
+        return 0;
+    }
+    return double(m_outcomes.count(Timeout)) / m_outcomes.size();
+}
+
+bool ProviderStats::isHealthy() const
+{
+    if (errorRate() < kUnhealthyErrorRate) {
+        return true;
+    }
+    // 一段时间没有失败后重新给机会，避免一直被排除
+    return m_lastFailure.isValid() && m_lastFailure.elapsed() > kRecoveryInterval;
+}
+
+int ProviderStats::adaptiveTimeout(int defaultTimeout) const
+{
+    if (m_latencies.size() < 5) {
+        return defaultTimeout;
+    }
+
+    // 取 p99 的 3 倍和 EWMA 的 4 倍中较大者（样本少时 p99 不稳定），限制在 [kMinTimeout, defaultTimeout] 之间
+    const qint64 timeout = qMax<qint64>(percentile(0.99) * 3, qint64(m_ewma * 4));
+    return int(qBound<qint64>(kMinTimeout, timeout, defaultTimeout));
+}
+
+QString ProviderStats::summary() const
+{
+    return QString("EWMA %1ms  p50 %2ms  p90 %3ms  p99 %4ms  错误 %5%  超时 %6%")
+        .arg(qRound(m_ewma))
+        .arg(percentile(0.5))
+        .arg(percentile(0.9))
+        .arg(percentile(0.99))
+        .arg(qRound(errorRate() * 100))
+        .arg(qRound(timeoutRate() * 100));
+}
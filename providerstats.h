@@ -0,0 +1,42 @@
+#ifndef PROVIDERSTATS_H
+#define PROVIDERSTATS_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+// 单个翻译服务商的运行统计：EWMA 延迟、延迟分位数、错误率和超时率。
+// 用于计算自适应超时时间和选择当前最快的健康服务商。
+class ProviderStats
+{
+public:
+    void recordSuccess(qint64 ms);
+    void recordError();
+    void recordTimeout();
+
+    int sampleCount() const { return m_latencies.size(); }
+    double ewmaLatency() const { return m_ewma; }
+    qint64 percentile(double p) const;
+    double errorRate() const;
+    double timeoutRate() const;
+
+    bool isHealthy() const;
+    int adaptiveTimeout(int defaultTimeout) const;
+    QString summary() const;
+
+private:
+    enum Outcome : char {
+        Success,
+        Error,
+        Timeout
+    };
+
+    void recordOutcome(Outcome outcome);
+
+    QList<qint64> m_latencies;  // 最近成功请求的耗时（毫秒）
+    QList<Outcome> m_outcomes;  // 最近请求的结果
+    double m_ewma{0};
+    QElapsedTimer m_lastFailure;
+};
+
+#endif // PROVIDERSTATS_H
@@ -0,0 +1,116 @@
+#include "requesttemplate.h"
+
+RequestTemplate::RequestTemplate(const QByteArray &pattern)
+{
+    QByteArray literal;
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        const char c = pattern.at(i);
+        if (c == '%' && i + 1 < pattern.size() && pattern.at(i + 1) >= '1' && pattern.at(i + 1) <= '9') {
+            m_literals.append(literal);
+            m_literalSize += literal.size();
+            literal.clear();
+            m_slots.append(pattern.at(++i) - '1');
+            continue;
+        }
+        literal += c;
+    }
+    m_literals.append(literal);
+    m_literalSize += literal.size();
+}
+
+QByteArray RequestTemplate::render(std::initializer_list<QByteArrayView> values) const
+{
+    const QByteArrayView *args = values.begin();
+    qsizetype size = m_literalSize;
+    for (int slot : m_slots) {
+        if (slot < int(values.size())) {
+            size += args[slot].size();
+        }
+    }
+
+    QByteArray out;
+    out.reserve(size);
+    for (qsizetype i = 0; i < m_slots.size(); ++i) {
+        out += m_literals.at(i);
+        if (m_slots.at(i) < int(values.size())) {
+            out.append(args[m_slots.at(i)]);
+        }
+    }
+    out += m_literals.last();
+    return out;
+}
+
+QByteArray RequestTemplate::stringArray(const QStringList &texts)
+{
+    qsizetype size = 0;
+    for (const QString &text : texts) {
+        size += text.size() * 3 + 3;
+    }
+
+    QByteArray out;
+    out.reserve(size);
+    for (const QString &text : texts) {
+        if (!out.isEmpty()) {
+            out += ',';
+        }
+        out += '"';
+        appendString(&out, text);
+        out += '"';
+    }
+    return out;
+}
+
+void RequestTemplate::appendString(QByteArray *out, QStringView text)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    // 每个 UTF-16 单元最多编码为 3 个字节，转义的少量超出由 QByteArray 自行扩容
+    if (out->capacity() - out->size() < text.size() * 3) {
+        out->reserve(out->size() + text.size() * 3 + 16);
+    }
+    const qsizetype count = text.size();
+    for (qsizetype i = 0; i < count; ++i) {
+        uint cp = text.at(i).unicode();
+        if (cp < 0x80) {
+            switch (cp) {
+            case '"': out->append("\\\""); break;
+            case '\\': out->append("\\\\"); break;
+            case '\n': out->append("\\n"); break;
+            case '\r': out->append("\\r"); break;
+            case '\t': out->append("\\t"); break;
+            case '\b': out->append("\\b"); break;
+            case '\f': out->append("\\f"); break;
+            default:
+                if (cp < 0x20) {
+                    out->append("\\u00");
+                    out->append(hex[cp >> 4]);
+                    out->append(hex[cp & 0xF]);
+                } else {
+                    out->append(char(cp));
+                }
+                break;
+            }
+            continue;
+        }
+
+        if (QChar::isHighSurrogate(cp) && i + 1 < count && text.at(i + 1).isLowSurrogate()) {
+            cp = QChar::surrogateToUcs4(char16_t(cp), text.at(++i).unicode());
+        } else if (QChar::isSurrogate(cp)) {
+            cp = 0xFFFD;  // 孤立的代理项
+        }
+
+        if (cp < 0x800) {
+            out->append(char(0xC0 | (cp >> 6)));
+            out->append(char(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out->append(char(0xE0 | (cp >> 12)));
+            out->append(char(0x80 | ((cp >> 6) & 0x3F)));
+            out->append(char(0x80 | (cp & 0x3F)));
+        } else {
+            out->append(char(0xF0 | (cp >> 18)));
+            out->append(char(0x80 | ((cp >> 12) & 0x3F)));
+            out->append(char(0x80 | ((cp >> 6) & 0x3F)));
+            out->append(char(0x80 | (cp & 0x3F)));
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef REQUESTTEMPLATE_H
+#define REQUESTTEMPLATE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QStringList>
+#include <QStringView>
+#include <initializer_list>
+
+// 预先编译好的请求体模板：固定部分只解析一次，发送时把文本和语言等
+// 变化的 JSON 片段按 %1、%2... 的位置拼接进去，整个请求体只分配一次。
+class RequestTemplate
+{
+public:
+    RequestTemplate() = default;
+    explicit RequestTemplate(const QByteArray &pattern);
+
+    // values 依次对应 %1、%2...，内容须已是合法的 JSON 片段
+    QByteArray render(std::initializer_list<QByteArrayView> values) const;
+
+    // 把文本编码为 JSON 字符串内容（不含两侧引号）追加到 out
+    static void appendString(QByteArray *out, QStringView text);
+    // 编码为逗号分隔的 JSON 字符串，用于填入数组的方括号之间
+    static QByteArray stringArray(const QStringList &texts);
+
+private:
+    QList<QByteArray> m_literals;  // 比占位符多一个
+    QList<int> m_slots;            // 每个占位符对应的参数序号（从 0 开始）
+    qsizetype m_literalSize{0};
+};
+
+#endif // REQUESTTEMPLATE_H
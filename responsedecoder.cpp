@@ -0,0 +1,425 @@
+#include "responsedecoder.h"
+#include "allocationcounter.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <cstring>
+#include <functional>
+
+namespace {
+const int kMaxDepth = 64;
+const int kMaxLiteral = 64;
+const qint64 kBenchNsecs = 200 * 1000 * 1000;  // 每种输入至少测量的时长
+
+// 火山翻译格式的响应，译文混合中文、转义字符和 Unicode 转义，总长约为 size 字节
+QByteArray benchResponse(qint64 size)
+{
+    const QByteArray sentence = QStringLiteral("这是一段用于测试解码速度的译文，包含 \\\"引号\\\"、换行\\n 和 caf\\u00e9。").toUtf8();
+    QByteArray data = "{\"translations\":[";
+    while (data.size() + sentence.size() + 64 < size) {
+        if (data.endsWith('"')) {
+            data += ',';
+        }
+        data += '"' + sentence + '"';
+    }
+    data += "],\"base_resp\":{\"status_code\":0,\"status_message\":\"\"}}";
+    return data;
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+}
+
+void ResponseDecoder::reset()
+{
+    m_arrays.clear();
+    m_values.clear();
+    m_state = ExpectValue;
+    m_stack.clear();
+    m_readingKey = false;
+    m_capture = false;
+    m_token.clear();
+    m_unicode = 0;
+    m_unicodeDigits = 0;
+    m_highSurrogate = 0;
+    m_error = false;
+    m_complete = false;
+}
+
+bool ResponseDecoder::fail()
+{
+    m_error = true;
+    return false;
+}
+
+QByteArray ResponseDecoder::currentPath() const
+{
+    QByteArray path;
+    for (const Frame &frame : m_stack) {
+        if (!frame.object) {
+            path += "[]";
+            continue;
+        }
+        if (!path.isEmpty())
+            path += '.';
+        path += frame.key;
+    }
+    return path;
+}
+
+void ResponseDecoder::beginValue()
+{
+    m_token.clear();
+    m_highSurrogate = 0;
+}
+
+void ResponseDecoder::endValue(const QByteArray &raw, bool isString)
+{
+    if (isString ? m_capture : !m_valuePaths.isEmpty()) {
+        const QByteArray path = currentPath();
+        if (isString && m_arrayPaths.contains(path))
+            m_arrays[path].append(QString::fromUtf8(raw));
+        else if (m_valuePaths.contains(path))
+            m_values.insert(path, QString::fromUtf8(raw));
+    }
+    m_capture = false;
+    if (m_stack.isEmpty()) {
+        m_state = Done;
+        m_complete = true;
+    } else {
+        m_state = ExpectCommaOrEnd;
+    }
+}
+
+void ResponseDecoder::appendCodePoint(uint cp)
+{
+    // 处理 😀 这样的代理对
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        m_highSurrogate = cp;
+        return;
+    }
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        if (!m_highSurrogate) {
+            cp = 0xFFFD;
+        } else {
+            cp = 0x10000 + ((m_highSurrogate - 0xD800) << 10) + (cp - 0xDC00);
+        }
+    } else if (m_highSurrogate) {
+        m_token += "\xEF\xBF\xBD";
+    }
+    m_highSurrogate = 0;
+
+    if (cp < 0x80) {
+        m_token += char(cp);
+    } else if (cp < 0x800) {
+        m_token += char(0xC0 | (cp >> 6));
+        m_token += char(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        m_token += char(0xE0 | (cp >> 12));
+        m_token += char(0x80 | ((cp >> 6) & 0x3F));
+        m_token += char(0x80 | (cp & 0x3F));
+    } else {
+        m_token += char(0xF0 | (cp >> 18));
+        m_token += char(0x80 | ((cp >> 12) & 0x3F));
+        m_token += char(0x80 | ((cp >> 6) & 0x3F));
+        m_token += char(0x80 | (cp & 0x3F));
+    }
+}
+
+bool ResponseDecoder::feed(const char *data, qsizetype size)
+{
+    if (m_error)
+        return false;
+
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end) {
+        const char c = *p;
+        switch (m_state) {
+        case InString: {
+            // 快速跳到下一个引号或转义符，中间的内容整段追加
+            const char *run = p;
+            while (run < end && *run != '"' && *run != '\\') {
+                if (uchar(*run) < 0x20)
+                    return fail();
+                ++run;
+            }
+            if (run > p && (m_capture || m_readingKey)) {
+                if (m_highSurrogate) {
+                    m_token += "\xEF\xBF\xBD";
+                    m_highSurrogate = 0;
+                }
+                m_token.append(p, run - p);
+            }
+            p = run;
+            if (p == end)
+                break;
+            if (*p == '\\') {
+                m_state = InStringEscape;
+            } else if (m_readingKey) {
+                m_stack.last().key = m_token;
+                m_readingKey = false;
+                m_state = ExpectColon;
+            } else {
+                if (m_highSurrogate)
+                    m_token += "\xEF\xBF\xBD";
+                endValue(m_token, true);
+            }
+            ++p;
+            break;
+        }
+        case InStringEscape: {
+            const bool keep = m_capture || m_readingKey;
+            char out = 0;
+            switch (c) {
+            case '"': out = '"'; break;
+            case '\\': out = '\\'; break;
+            case '/': out = '/'; break;
+            case 'b': out = '\b'; break;
+            case 'f': out = '\f'; break;
+            case 'n': out = '\n'; break;
+            case 'r': out = '\r'; break;
+            case 't': out = '\t'; break;
+            case 'u':
+                m_unicode = 0;
+                m_unicodeDigits = 0;
+                m_state = InStringUnicode;
+                ++p;
+                continue;
+            default:
+                return fail();
+            }
+            if (keep)
+                appendCodePoint(uchar(out));
+            m_state = InString;
+            ++p;
+            break;
+        }
+        case InStringUnicode: {
+            const int digit = hexValue(c);
+            if (digit < 0)
+                return fail();
+            m_unicode = (m_unicode << 4) | uint(digit);
+            if (++m_unicodeDigits == 4) {
+                if (m_capture || m_readingKey)
+                    appendCodePoint(m_unicode);
+                m_state = InString;
+            }
+            ++p;
+            break;
+        }
+        case InLiteral:
+            if (isSpace(c) || c == ',' || c == '}' || c == ']') {
+                endValue(m_token, false);
+                continue; // 分隔符交给 ExpectCommaOrEnd 处理
+            }
+            if (m_token.size() >= kMaxLiteral)
+                return fail();
+            m_token += c;
+            ++p;
+            break;
+        case ExpectValue:
+            if (isSpace(c)) {
+                ++p;
+                break;
+            }
+            if (c == '{' || c == '[') {
+                if (m_stack.size() >= kMaxDepth)
+                    return fail();
+                Frame frame;
+                frame.object = c == '{';
+                m_stack.append(frame);
+                m_state = frame.object ? ExpectKeyOrEnd : ExpectValue;
+                ++p;
+                // 空数组：[ 之后直接是 ]
+                if (!frame.object) {
+                    while (p < end && isSpace(*p))
+                        ++p;
+                    if (p < end && *p == ']') {
+                        m_stack.removeLast();
+                        m_state = m_stack.isEmpty() ? Done : ExpectCommaOrEnd;
+                        m_complete = m_stack.isEmpty();
+                        ++p;
+                    }
+                }
+                break;
+            }
+            if (c == ']' && !m_stack.isEmpty() && !m_stack.last().object) {
+                // 跨数据段的空数组
+                m_stack.removeLast();
+                m_state = m_stack.isEmpty() ? Done : ExpectCommaOrEnd;
+                m_complete = m_stack.isEmpty();
+                ++p;
+                break;
+            }
+            beginValue();
+            if (c == '"') {
+                m_readingKey = false;
+                m_capture = !m_arrayPaths.isEmpty() || !m_valuePaths.isEmpty();
+                if (m_capture) {
+                    const QByteArray path = currentPath();
+                    m_capture = m_arrayPaths.contains(path) || m_valuePaths.contains(path);
+                }
+                m_state = InString;
+            } else if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+                m_token += c;
+                m_state = InLiteral;
+            } else {
+                return fail();
+            }
+            ++p;
+            break;
+        case ExpectKeyOrEnd:
+        case ExpectKey:
+            if (isSpace(c)) {
+                ++p;
+                break;
+            }
+            if (c == '}' && m_state == ExpectKeyOrEnd) {
+                m_stack.removeLast();
+                m_state = m_stack.isEmpty() ? Done : ExpectCommaOrEnd;
+                m_complete = m_stack.isEmpty();
+                ++p;
+                break;
+            }
+            if (c != '"')
+                return fail();
+            beginValue();
+            m_readingKey = true;
+            m_state = InString;
+            ++p;
+            break;
+        case ExpectColon:
+            if (isSpace(c)) {
+                ++p;
+                break;
+            }
+            if (c != ':')
+                return fail();
+            m_state = ExpectValue;
+            ++p;
+            break;
+        case ExpectCommaOrEnd:
+            if (isSpace(c)) {
+                ++p;
+                break;
+            }
+            if (m_stack.isEmpty())
+                return fail();
+            if (c == ',') {
+                m_state = m_stack.last().object ? ExpectKey : ExpectValue;
+            } else if ((c == '}' && m_stack.last().object) || (c == ']' && !m_stack.last().object)) {
+                m_stack.removeLast();
+                m_state = m_stack.isEmpty() ? Done : ExpectCommaOrEnd;
+                m_complete = m_stack.isEmpty();
+            } else {
+                return fail();
+            }
+            ++p;
+            break;
+        case Done:
+            if (!isSpace(c))
+                return fail();
+            ++p;
+            break;
+        }
+    }
+    return true;
+}
+
+bool ResponseDecoder::isBenchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--decode-bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int ResponseDecoder::benchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Response decoder benchmark against QJsonDocument.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("decode-bench", "Response sizes in KB.", "kb,...", "10,100,1000,5000");
+    QCommandLineOption chunkOption("chunk", "Bytes fed to the streaming decoder per call.", "bytes", "16384");
+    parser.addOptions({benchOption, chunkOption});
+    parser.process(arguments);
+
+    const qsizetype chunk = qMax(1, parser.value(chunkOption).toInt());
+    QTextStream err(stderr);
+    if (!AllocationCounter::isSupported()) {
+        err << "allocation counts need a build configured with -DTRANSLATE_ALLOCATION_COUNTER=ON\n";
+    }
+
+    for (const QString &item : parser.value(benchOption).split(',', Qt::SkipEmptyParts)) {
+        const QByteArray data = benchResponse(item.toLongLong() * 1024);
+        qsizetype expected = 0;
+
+        // 两种实现交替各跑至少 kBenchNsecs，取平均耗时和每次解析的分配次数
+        auto measure = [&data](const std::function<qsizetype()> &parse, qsizetype *translations) {
+            int runs = 0;
+            qint64 nsecs = 0;
+            const quint64 allocations = AllocationCounter::count();
+            QElapsedTimer timer;
+            while (nsecs < kBenchNsecs || runs < 3) {
+                timer.start();
+                *translations = parse();
+                nsecs += timer.nsecsElapsed();
+                ++runs;
+            }
+            const double perRun = nsecs / 1e3 / runs;
+            return QString("%1 us  %2 MB/s  %3 allocs")
+                .arg(perRun, 0, 'f', 1)
+                .arg(data.size() / perRun, 0, 'f', 1)
+                .arg(AllocationCounter::isSupported()
+                         ? QString::number(double(AllocationCounter::count() - allocations) / runs, 'f', 0)
+                         : QString("n/a"));
+        };
+
+        qsizetype streamed = 0;
+        const QString streaming = measure([&data, chunk]() -> qsizetype {
+            ResponseDecoder decoder;
+            decoder.watchArray("translations[]");
+            decoder.watchValue("base_resp.status_code");
+            for (qsizetype offset = 0; offset < data.size(); offset += chunk) {
+                decoder.feed(data.constData() + offset, qMin(chunk, data.size() - offset));
+            }
+            return decoder.isComplete() ? decoder.array("translations[]").size() : -1;
+        }, &streamed);
+        const QString document = measure([&data]() -> qsizetype {
+            const QJsonObject json = QJsonDocument::fromJson(data).object();
+            QStringList results;
+            for (const QJsonValue &value : json["translations"].toArray()) {
+                results.append(value.toString());
+            }
+            return json["base_resp"].toObject()["status_code"].toInt() == 0 ? results.size() : -1;
+        }, &expected);
+
+        err << QString("%1 KB (%2 strings)\n").arg(data.size() / 1024).arg(expected);
+        err << "  streaming:     " << streaming << "\n";
+        err << "  QJsonDocument: " << document << "\n";
+        if (streamed != expected) {
+            err << "  mismatch: streaming decoder found " << streamed << " strings\n";
+            err.flush();
+            return 2;
+        }
+    }
+    err.flush();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef RESPONSEDECODER_H
+#define RESPONSEDECODER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// 增量 JSON 解码器：随网络数据到达逐段输入，不构建 DOM，
+// 只提取事先登记路径上的字符串数组和标量值。
+// 路径用点号连接对象键，数组元素用 [] 表示，例如 "translations[]"、"header.ret_code"。
+class ResponseDecoder
+{
+public:
+    void watchArray(const QByteArray &path) { m_arrayPaths.append(path); }
+    void watchValue(const QByteArray &path) { m_valuePaths.append(path); }
+
+    // 输入下一段数据，返回 false 表示格式错误
+    bool feed(const char *data, qsizetype size);
+    bool feed(const QByteArray &data) { return feed(data.constData(), data.size()); }
+    void reset();
+
+    bool hasError() const { return m_error; }
+    bool isComplete() const { return m_complete; }
+
+    // --decode-bench：按 10 KB 到 5 MB 的响应比较本解码器和 QJsonDocument 的耗时与分配次数
+    static bool isBenchMode(int argc, char *argv[]);
+    static int benchmark(const QStringList &arguments);
+
+    bool contains(const QByteArray &path) const { return m_arrays.contains(path) || m_values.contains(path); }
+    QStringList array(const QByteArray &path) const { return m_arrays.value(path); }
+    QString value(const QByteArray &path) const { return m_values.value(path); }
+
+private:
+    enum State {
+        ExpectValue,        // 等待一个值
+        ExpectKeyOrEnd,     // 对象中等待键或 }
+        ExpectKey,          // 对象中逗号之后等待键
+        ExpectColon,
+        ExpectCommaOrEnd,   // 值之后等待逗号或容器结束
+        InString,
+        InStringEscape,
+        InStringUnicode,
+        InLiteral,          // 数字、true、false、null
+        Done
+    };
+
+    struct Frame {
+        bool object{false};
+        QByteArray key;
+    };
+
+    bool fail();
+    QByteArray currentPath() const;
+    void beginValue();
+    void endValue(const QByteArray &raw, bool isString);
+    void appendCodePoint(uint codePoint);
+
+    QList<QByteArray> m_arrayPaths;
+    QList<QByteArray> m_valuePaths;
+    QHash<QByteArray, QStringList> m_arrays;
+    QHash<QByteArray, QString> m_values;
+
+    State m_state{ExpectValue};
+    QList<Frame> m_stack;
+    bool m_readingKey{false};
+    bool m_capture{false};        // 当前字符串是否需要保存
+    QByteArray m_token;           // 当前字符串（UTF-8）或字面量
+    uint m_unicode{0};
+    int m_unicodeDigits{0};
+    uint m_highSurrogate{0};
+    bool m_error{false};
+    bool m_complete{false};
+};
+
+#endif // RESPONSEDECODER_H
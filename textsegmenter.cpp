@@ -0,0 +1,344 @@
+#include "textsegmenter.h"
+
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+const int kMinReflowWidth = 40;  // PDF 正文行宽下限（字符），更短的多为列表、表格或日志
+
+// 句点之后通常不结束句子的缩写（小写比较，不含最后的句点）
+const QSet<QString> &abbreviations()
+{
+    static const QSet<QString> words{
+        "mr", "mrs", "ms", "dr", "prof", "sr", "jr", "st", "mt", "vs", "etc", "no", "fig", "figs",
+        "vol", "eq", "al", "approx", "inc", "ltd", "co", "corp", "dept", "est", "e.g", "i.e", "cf",
+        "jan", "feb", "mar", "apr", "jun", "jul", "aug", "sep", "sept", "oct", "nov", "dec",
+    };
+    return words;
+}
+}
+
+QList<TextSegment> TextSegmenter::split(const QString &text, int maxChars)
+{
+    QList<TextSegment> segments;
+    if (maxChars <= 0) {
+        maxChars = text.size();
+    }
+
+    const int length = text.size();
+    int pos = 0;
+    while (pos < length) {
+        int end = length;
+        if (length - pos > maxChars) {
+            end = findBreak(text, pos, pos + maxChars);
+        }
+
+        // 片段末尾和下一段开头的空白作为分隔符，不发送给翻译服务
+        int textEnd = end;
+        while (textEnd > pos && text.at(textEnd - 1).isSpace()) {
+            --textEnd;
+        }
+        int next = end;
+        while (next < length && text.at(next).isSpace()) {
+            ++next;
+        }
+
+        TextSegment segment{text.mid(pos, textEnd - pos), text.mid(textEnd, next - textEnd)};
+        if (segment.text.isEmpty() && !segments.isEmpty()) {
+            segments.last().separator += segment.separator;
+        } else {
+            segments.append(segment);
+        }
+        pos = next;
+    }
+    return segments;
+}
+
+QList<TextSegment> TextSegmenter::sentences(const QString &text)
+{
+    QList<TextSegment> segments;
+    const int length = text.size();
+    int pos = 0;
+    while (pos < length && text.at(pos).isSpace()) {
+        ++pos;
+    }
+    if (pos > 0) {
+        segments.append({QString(), text.left(pos)});
+    }
+
+    while (pos < length) {
+        int end = pos;
+        while (end < length && text.at(end) != '\n') {
+            if (isSentenceEnd(text, end++)) {
+                // 句末的引号和括号属于本句
+                while (end < length && isClosing(text.at(end))) {
+                    ++end;
+                }
+                break;
+            }
+        }
+
+        int textEnd = end;
+        while (textEnd > pos && text.at(textEnd - 1).isSpace()) {
+            --textEnd;
+        }
+        int next = end;
+        while (next < length && text.at(next).isSpace()) {
+            ++next;
+        }
+        segments.append({text.mid(pos, textEnd - pos), text.mid(textEnd, next - textEnd)});
+        pos = next;
+    }
+    return segments;
+}
+
+QString TextSegmenter::join(const QList<TextSegment> &segments)
+{
+    QString result;
+    for (const TextSegment &segment : segments) {
+        result += segment.text;
+        result += segment.separator;
+    }
+    return result;
+}
+
+bool TextSegmenter::looksReflowed(const QString &text)
+{
+    // PDF 排版的段落中除段尾行外各行宽度接近；日志、表格和代码的行宽参差不齐
+    const QStringList lines = text.split('\n');
+    QList<int> widths;
+    for (int i = 0; i < lines.size(); ++i) {
+        const int width = int(lines.at(i).trimmed().size());
+        const bool paragraphEnd = i + 1 >= lines.size() || lines.at(i + 1).trimmed().isEmpty();
+        if (width > 0 && !paragraphEnd) {
+            widths.append(width);
+        }
+    }
+    if (widths.size() < 2) {
+        return false;
+    }
+
+    QList<int> sorted = widths;
+    std::sort(sorted.begin(), sorted.end());
+    const int lineWidth = sorted.at(sorted.size() * 9 / 10);
+    if (lineWidth < kMinReflowWidth) {
+        return false;
+    }
+    int full = 0;
+    for (int width : std::as_const(widths)) {
+        if (width * 10 >= lineWidth * 7) {
+            ++full;
+        }
+    }
+    return full * 4 >= widths.size() * 3;
+}
+
+QString TextSegmenter::repairLineBreaks(const QString &text)
+{
+    if (!looksReflowed(text)) {
+        return text;
+    }
+
+    QString result;
+    result.reserve(text.size());
+    const int length = text.size();
+    for (int i = 0; i < length; ++i) {
+        const QChar ch = text.at(i);
+        if (ch != '\n') {
+            result += ch;
+            continue;
+        }
+
+        int lineEnd = result.size();
+        while (lineEnd > 0 && (result.at(lineEnd - 1) == ' ' || result.at(lineEnd - 1) == '\t'
+                               || result.at(lineEnd - 1) == '\r')) {
+            --lineEnd;
+        }
+        int next = i + 1;
+        while (next < length && (text.at(next) == ' ' || text.at(next) == '\t')) {
+            ++next;
+        }
+
+        // 空行是段落边界；只有下一行以小写字母开头时才认为是排版造成的断行
+        if (lineEnd == 0 || next >= length || !text.at(next).isLower()) {
+            result += ch;
+            continue;
+        }
+
+        const QChar last = result.at(lineEnd - 1);
+        if (last == '-' && lineEnd >= 2 && result.at(lineEnd - 2).isLetter()) {
+            // trans-\nlation -> translation；只有拼合后的词在文中别处出现过才去掉连字符，
+            // 否则按 well-\nknown 这样的复合词保留
+            int wordStart = lineEnd - 1;
+            while (wordStart > 0 && result.at(wordStart - 1).isLetter()) {
+                --wordStart;
+            }
+            int wordEnd = next;
+            while (wordEnd < length && text.at(wordEnd).isLetter()) {
+                ++wordEnd;
+            }
+            const QString joined = result.mid(wordStart, lineEnd - 1 - wordStart) + text.mid(next, wordEnd - next);
+            const bool hyphenated = !containsWord(text, joined);
+            result.truncate(hyphenated ? lineEnd : lineEnd - 1);
+            i = next - 1;
+        } else if (last.isLetter() || last == ',') {
+            result.truncate(lineEnd);
+            result += ' ';
+            i = next - 1;
+        } else {
+            result += ch;
+        }
+    }
+    return result;
+}
+
+bool TextSegmenter::containsWord(const QString &text, const QString &word)
+{
+    qsizetype from = 0;
+    while ((from = text.indexOf(word, from, Qt::CaseInsensitive)) >= 0) {
+        const qsizetype end = from + word.size();
+        if ((from == 0 || !text.at(from - 1).isLetter()) && (end >= text.size() || !text.at(end).isLetter())) {
+            return true;
+        }
+        from = end;
+    }
+    return false;
+}
+
+bool TextSegmenter::isTrivial(QStringView text)
+{
+    for (QChar ch : text) {
+        if (ch.isLetter() || ch.isHighSurrogate()) {  // 代理对按字母处理（扩展区汉字等）
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextSegmenter::isClosing(QChar ch)
+{
+    switch (ch.unicode()) {
+    case '"':
+    case '\'':
+    case ')':
+    case ']':
+    case 0x201D:  // ”
+    case 0x2019:  // ’
+    case 0x300D:  // 」
+    case 0x300F:  // 』
+    case 0xFF09:  // ）
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool TextSegmenter::isAbbreviation(const QString &text, int dot)
+{
+    int start = dot;
+    while (start > 0 && !text.at(start - 1).isSpace() && !isClosing(text.at(start - 1))
+           && text.at(start - 1) != '(') {
+        --start;
+    }
+    const QString word = text.mid(start, dot - start).toLower();
+    if (word.isEmpty()) {
+        return false;
+    }
+
+    // 单个大写字母是姓名缩写（J. K. Rowling）
+    if (word.size() == 1 && text.at(start).isUpper()) {
+        return true;
+    }
+    // 行首的数字是列表序号（1. 2. 3.）
+    if (start == 0 || text.at(start - 1) == '\n') {
+        bool number = true;
+        for (QChar ch : word) {
+            number = number && ch.isDigit();
+        }
+        if (number) {
+            return true;
+        }
+    }
+    return abbreviations().contains(word);
+}
+
+bool TextSegmenter::isSentenceEnd(const QString &text, int pos)
+{
+    const QChar ch = text.at(pos);
+    switch (ch.unicode()) {
+    case 0x3002:  // 。
+    case 0xFF01:  // ！
+    case 0xFF1F:  // ？
+    case 0xFF1B:  // ；
+        return true;
+    case '.':
+    case '!':
+    case '?': {
+        // 西文标点后（可隔着引号、括号）需要跟空白，避免切开小数、网址和 foo.bar() 这样的代码
+        int next = pos + 1;
+        while (next < text.size() && isClosing(text.at(next))) {
+            ++next;
+        }
+        if (next >= text.size()) {
+            return true;
+        }
+        if (!text.at(next).isSpace()) {
+            return false;
+        }
+        if (ch == '.') {
+            if (isAbbreviation(text, pos)) {
+                return false;
+            }
+            // 下一个词以小写字母开头时多半是未收录的缩写，不断句
+            int word = next;
+            while (word < text.size() && text.at(word).isSpace() && text.at(word) != '\n') {
+                ++word;
+            }
+            if (word < text.size() && text.at(word).isLower()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+int TextSegmenter::findBreak(const QString &text, int start, int limit)
+{
+    // 只在后 3/4 的范围内寻找边界，避免产生过小的批次
+    const int minimum = start + (limit - start) / 4 + 1;
+
+    // 段落边界
+    for (int i = limit; i > minimum; --i) {
+        if (text.at(i - 1) == '\n' && text.at(i - 2) == '\n') {
+            return i;
+        }
+    }
+    // 行边界
+    for (int i = limit; i > minimum; --i) {
+        if (text.at(i - 1) == '\n') {
+            return i;
+        }
+    }
+    // 句子边界
+    for (int i = limit; i > minimum; --i) {
+        if (isSentenceEnd(text, i - 1)) {
+            return i;
+        }
+    }
+    // 单词边界
+    for (int i = limit; i > minimum; --i) {
+        if (text.at(i - 1).isSpace()) {
+            return i;
+        }
+    }
+
+    // 找不到边界时硬切，但不拆开代理对
+    if (text.at(limit - 1).isHighSurrogate()) {
+        return limit - 1;
+    }
+    return limit;
+}
@@ -0,0 +1,40 @@
+#ifndef TEXTSEGMENTER_H
+#define TEXTSEGMENTER_H
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// 切分后的片段，separator 为片段后原文中的空白，拼接时原样保留
+struct TextSegment
+{
+    QString text;
+    QString separator;
+    bool verbatim{false};  // 标签、代码等结构，不翻译，原样输出
+};
+
+// 把长文本按段落、行、句子边界切分为不超过 maxChars 的批次
+class TextSegmenter
+{
+public:
+    static QList<TextSegment> split(const QString &text, int maxChars);
+    // 按句子和行切分，每个片段不含换行；开头的空白作为一个空文本片段
+    static QList<TextSegment> sentences(const QString &text);
+    static QString join(const QList<TextSegment> &segments);
+
+    // 修复从 PDF 复制时产生的断行：连字符断开的单词重新拼合，句中换行改为空格。
+    // 只处理看起来是 PDF 排版的文本（多数行宽度接近），其他文本原样返回
+    static QString repairLineBreaks(const QString &text);
+    static bool looksReflowed(const QString &text);
+    // 不含任何字母（数字、标点、分隔线等）的片段无需翻译
+    static bool isTrivial(QStringView text);
+
+private:
+    static int findBreak(const QString &text, int start, int limit);
+    static bool isSentenceEnd(const QString &text, int pos);
+    static bool isClosing(QChar ch);
+    static bool containsWord(const QString &text, const QString &word);
+    static bool isAbbreviation(const QString &text, int dot);
+};
+
+#endif // TEXTSEGMENTER_H
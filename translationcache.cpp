@@ -0,0 +1,66 @@
+#include "translationcache.h"
+
+#include <QStringList>
+
+TranslationCache::TranslationCache(qint64 maxBytes)
+    : m_cache(maxBytes)
+{
+}
+
+QString TranslationCache::normalize(const QString &text)
+{
+    // 统一换行符并去掉行尾空白，保留行结构（V1 按行翻译）
+    QString normalized = text;
+    normalized.replace("\r\n", "\n");
+    normalized.replace('\r', '\n');
+
+    QStringList lines = normalized.split('\n');
+    for (QString &line : lines) {
+        int end = line.size();
+        while (end > 0 && line.at(end - 1).isSpace()) {
+            --end;
+        }
+        line.truncate(end);
+    }
+    return lines.join('\n').trimmed();
+}
+
+QString TranslationCache::makeKey(const QString &provider, const QString &sourceLang,
+                                  const QString &targetLang, const QString &text)
+{
+    // 使用不会出现在语言代码中的分隔符
+    return provider + QChar(0x1F) + sourceLang + QChar(0x1F) + targetLang
+           + QChar(0x1F) + normalize(text);
+}
+
+bool TranslationCache::lookup(const QString &key, QString *result)
+{
+    // QCache::object() 会把命中的条目移到最近使用的位置
+    const QString *cached = m_cache.object(key);
+    if (!cached) {
+        ++m_misses;
+        return false;
+    }
+
+    ++m_hits;
+    if (result) {
+        *result = *cached;
+    }
+    return true;
+}
+
+void TranslationCache::insert(const QString &key, const QString &result)
+{
+    if (key.isEmpty() || result.isEmpty()) {
+        return;
+    }
+
+    // 以 UTF-16 字节数计费；超过预算的单条结果由 QCache 直接丢弃
+    const qint64 cost = (key.size() + result.size()) * qint64(sizeof(QChar));
+    m_cache.insert(key, new QString(result), cost);
+}
+
+void TranslationCache::clear()
+{
+    m_cache.clear();
+}
@@ -0,0 +1,34 @@
+#ifndef TRANSLATIONCACHE_H
+#define TRANSLATIONCACHE_H
+
+#include <QCache>
+#include <QString>
+
+// 翻译结果的内存 LRU 缓存，按 (服务商, 源语言, 目标语言, 规范化文本) 作为键，
+// 以字节数作为容量预算
+class TranslationCache
+{
+public:
+    explicit TranslationCache(qint64 maxBytes = 8 * 1024 * 1024);
+
+    static QString normalize(const QString &text);
+    static QString makeKey(const QString &provider, const QString &sourceLang,
+                           const QString &targetLang, const QString &text);
+
+    bool lookup(const QString &key, QString *result);
+    void insert(const QString &key, const QString &result);
+    void clear();
+
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    qint64 bytes() const { return m_cache.totalCost(); }
+    qint64 maxBytes() const { return m_cache.maxCost(); }
+    int count() const { return m_cache.count(); }
+
+private:
+    QCache<QString, QString> m_cache;
+    quint64 m_hits{0};
+    quint64 m_misses{0};
+};
+
+#endif // TRANSLATIONCACHE_H
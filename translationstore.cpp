@@ -0,0 +1,559 @@
+#include "translationstore.h"
+#include "translationcache.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const char kFileMagic[8] = {'T', 'R', 'S', 'T', 'O', 'R', 'E', '1'};
+const quint32 kRecordMagic = 0x52454354;  // "TCER"
+const qint64 kHeaderSize = 24;
+
+// 索引文件：魔数、覆盖的数据长度、最后一条记录的偏移（无记录时为 -1），之后每项为键哈希和记录偏移
+const char kIndexMagic[8] = {'T', 'R', 'I', 'N', 'D', 'E', 'X', '1'};
+const qint64 kIndexHeaderSize = 24;
+const qint64 kIndexEntrySize = 16;
+}
+
+TranslationStore::TranslationStore(QObject *parent)
+    : QObject{parent}
+{
+}
+
+TranslationStore::~TranslationStore()
+{
+    close();
+}
+
+QString TranslationStore::defaultPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/translations.db";
+}
+
+quint64 TranslationStore::hashKey(const QByteArray &key)
+{
+    // FNV-1a，保证不同进程间哈希值一致
+    quint64 hash = 14695981039346656037ULL;
+    for (char ch : key) {
+        hash ^= static_cast<uchar>(ch);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool TranslationStore::readHeader(const uchar *data, qint64 size, qint64 offset, RecordHeader *header)
+{
+    if (offset + kHeaderSize > size) {
+        return false;
+    }
+
+    const uchar *p = data + offset;
+    header->magic = qFromLittleEndian<quint32>(p);
+    header->keyLength = qFromLittleEndian<quint32>(p + 4);
+    header->valueLength = qFromLittleEndian<quint32>(p + 8);
+    header->reserved = qFromLittleEndian<quint32>(p + 12);
+    header->hash = qFromLittleEndian<quint64>(p + 16);
+
+    if (header->magic != kRecordMagic) {
+        return false;
+    }
+    return offset + kHeaderSize + header->keyLength + header->valueLength <= size;
+}
+
+qint64 TranslationStore::buildIndex(const uchar *data, qint64 size, qint64 offset,
+                                    QHash<quint64, qint64> *index, qint64 *lastRecord)
+{
+    // 从 offset 开始只读取记录头并跳过正文，返回最后一条完整记录的结束位置
+    RecordHeader header;
+    while (readHeader(data, size, offset, &header)) {
+        index->insert(header.hash, offset);
+        *lastRecord = offset;
+        offset += kHeaderSize + header.keyLength + header.valueLength;
+    }
+    return offset;
+}
+
+bool TranslationStore::writeIndex(const QString &path, const QHash<quint64, qint64> &index, qint64 dataSize, qint64 lastRecord)
+{
+    QByteArray data(kIndexHeaderSize + index.size() * kIndexEntrySize, Qt::Uninitialized);
+    uchar *p = reinterpret_cast<uchar *>(data.data());
+    std::memcpy(p, kIndexMagic, sizeof(kIndexMagic));
+    qToLittleEndian<qint64>(dataSize, p + 8);
+    qToLittleEndian<qint64>(lastRecord, p + 16);
+    p += kIndexHeaderSize;
+    for (auto it = index.cbegin(); it != index.cend(); ++it, p += kIndexEntrySize) {
+        qToLittleEndian<quint64>(it.key(), p);
+        qToLittleEndian<qint64>(it.value(), p + 8);
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Failed to write translation store index:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 TranslationStore::loadIndex()
+{
+    // 返回索引覆盖的数据长度，索引不可用时返回 -1
+    QFile file(indexPath(m_file.fileName()));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < kIndexHeaderSize || (data.size() - kIndexHeaderSize) % kIndexEntrySize != 0
+        || std::memcmp(data.constData(), kIndexMagic, sizeof(kIndexMagic)) != 0) {
+        return -1;
+    }
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    const qint64 dataSize = qFromLittleEndian<qint64>(p + 8);
+    const qint64 lastRecord = qFromLittleEndian<qint64>(p + 16);
+
+    // 数据文件被截断、替换或索引写入后追加失败时，最后一条记录对不上
+    if (dataSize > m_mappedSize) {
+        return -1;
+    }
+    if (lastRecord < 0) {
+        if (dataSize != qint64(sizeof(kFileMagic))) {
+            return -1;
+        }
+    } else {
+        RecordHeader header;
+        if (!readHeader(m_map, m_mappedSize, lastRecord, &header)
+            || lastRecord + kHeaderSize + header.keyLength + header.valueLength != dataSize) {
+            return -1;
+        }
+    }
+
+    const qsizetype count = (data.size() - kIndexHeaderSize) / kIndexEntrySize;
+    m_index.reserve(count);
+    p += kIndexHeaderSize;
+    for (qsizetype i = 0; i < count; ++i, p += kIndexEntrySize) {
+        const qint64 offset = qFromLittleEndian<qint64>(p + 8);
+        if (offset < qint64(sizeof(kFileMagic)) || offset > lastRecord) {
+            m_index.clear();
+            return -1;
+        }
+        m_index.insert(qFromLittleEndian<quint64>(p), offset);
+    }
+    m_lastRecord = lastRecord;
+    return dataSize;
+}
+
+bool TranslationStore::open(const QString &path, qint64 maxFileSize)
+{
+    close();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_maxFileSize = maxFileSize;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Failed to open translation store:" << path << m_file.errorString();
+        return false;
+    }
+
+    if (m_file.size() < qint64(sizeof(kFileMagic))) {
+        m_file.resize(0);
+        m_file.write(kFileMagic, sizeof(kFileMagic));
+        m_file.flush();
+        QFile::remove(indexPath(path));
+    }
+
+    if (!remap() || std::memcmp(m_map, kFileMagic, sizeof(kFileMagic)) != 0) {
+        qWarning() << "Invalid translation store file:" << path;
+        closeFile(false);
+        return false;
+    }
+
+    // 索引文件可用时只扫描其后追加的记录（上次未正常关闭时写入的部分），否则从头扫描
+    m_indexedSize = loadIndex();
+    const qint64 scanFrom = m_indexedSize >= 0 ? m_indexedSize : qint64(sizeof(kFileMagic));
+    const qint64 validSize = buildIndex(m_map, m_mappedSize, scanFrom, &m_index, &m_lastRecord);
+    if (validSize < m_mappedSize) {
+        // 丢弃上次异常退出时写了一半的记录
+        qWarning() << "Truncating incomplete records in translation store at" << validSize;
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_file.resize(validSize);
+        remap();
+    }
+
+    qDebug() << "Translation store opened:" << m_index.size() << "entries,"
+             << m_fileSize << "bytes in" << timer.nsecsElapsed() / 1000 << "us";
+    return true;
+}
+
+void TranslationStore::close()
+{
+    closeFile(true);
+}
+
+void TranslationStore::closeFile(bool saveIndex)
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        // 先把缓冲的记录写入数据文件，索引记下的长度才与文件一致
+        if (saveIndex && m_file.flush() && m_indexedSize != m_fileSize) {
+            writeIndex(indexPath(m_file.fileName()), m_index, m_fileSize, m_lastRecord);
+        }
+        m_file.close();
+    }
+    m_mappedSize = 0;
+    m_fileSize = 0;
+    m_index.clear();
+    m_lastRecord = -1;
+    m_indexedSize = -1;
+}
+
+bool TranslationStore::remap()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    m_fileSize = m_file.size();
+    m_mappedSize = 0;
+    if (m_fileSize <= 0) {
+        return false;
+    }
+
+    m_map = m_file.map(0, m_fileSize);
+    if (!m_map) {
+        qWarning() << "Failed to map translation store:" << m_file.errorString();
+        return false;
+    }
+    m_mappedSize = m_fileSize;
+    return true;
+}
+
+bool TranslationStore::lookup(const QString &key, QString *result)
+{
+    if (!m_map) {
+        return false;
+    }
+
+    const QByteArray keyData = key.toUtf8();
+    auto it = m_index.constFind(hashKey(keyData));
+    if (it == m_index.constEnd()) {
+        return false;
+    }
+
+    // 新追加的记录还不在映射范围内时重新映射
+    if (it.value() + kHeaderSize > m_mappedSize && !remap()) {
+        return false;
+    }
+
+    RecordHeader header;
+    if (!readHeader(m_map, m_mappedSize, it.value(), &header)) {
+        return false;
+    }
+
+    // 直接在映射内存上比较键，避免哈希冲突
+    const uchar *keyPtr = m_map + it.value() + kHeaderSize;
+    if (header.keyLength != quint32(keyData.size())
+        || std::memcmp(keyPtr, keyData.constData(), header.keyLength) != 0) {
+        return false;
+    }
+
+    if (result) {
+        *result = QString::fromUtf8(reinterpret_cast<const char *>(keyPtr + header.keyLength),
+                                    header.valueLength);
+    }
+    return true;
+}
+
+void TranslationStore::insert(const QString &key, const QString &result)
+{
+    if (!m_file.isOpen() || key.isEmpty() || result.isEmpty()) {
+        return;
+    }
+
+    const QByteArray keyData = key.toUtf8();
+    const QByteArray valueData = result.toUtf8();
+    const quint64 hash = hashKey(keyData);
+
+    uchar header[kHeaderSize];
+    qToLittleEndian<quint32>(kRecordMagic, header);
+    qToLittleEndian<quint32>(quint32(keyData.size()), header + 4);
+    qToLittleEndian<quint32>(quint32(valueData.size()), header + 8);
+    qToLittleEndian<quint32>(0, header + 12);
+    qToLittleEndian<quint64>(hash, header + 16);
+
+    // 写入 QFile 的缓冲区，缓冲满、查询需要重新映射或关闭时才写到文件，交互路径上不逐条调用 flush。
+    // seek 会清空缓冲，位置已在末尾时不调用
+    const qint64 offset = m_fileSize;
+    if (m_file.pos() != offset) {
+        m_file.seek(offset);
+    }
+    if (m_file.write(reinterpret_cast<const char *>(header), kHeaderSize) != kHeaderSize
+        || m_file.write(keyData) != keyData.size()
+        || m_file.write(valueData) != valueData.size()) {
+        qWarning() << "Failed to append to translation store:" << m_file.errorString();
+        // 映射存在时 Windows 不允许改变文件长度，先解除映射再截掉写了一半的记录
+        if (m_map) {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+            m_mappedSize = 0;
+        }
+        m_file.resize(offset);
+        remap();
+        return;
+    }
+
+    m_fileSize = offset + kHeaderSize + keyData.size() + valueData.size();
+    m_index.insert(hash, offset);
+    m_lastRecord = offset;
+
+    if (m_fileSize > m_maxFileSize) {
+        startCompaction();
+    }
+}
+
+void TranslationStore::startCompaction()
+{
+    if (m_compacting) {
+        return;
+    }
+    m_compacting = true;
+    // 后台线程按快照长度映射文件，缓冲中的记录须先写入
+    m_file.flush();
+
+    // 按偏移排序的存活记录；偏移越大越新，超出上限时优先保留新记录
+    QList<qint64> liveOffsets = m_index.values();
+    std::sort(liveOffsets.begin(), liveOffsets.end());
+
+    const QString path = m_file.fileName();
+    const QString compactPath = path + ".compact";
+    const qint64 snapshotSize = m_fileSize;
+    const qint64 budget = m_maxFileSize / 2;
+
+    QPointer<TranslationStore> self(this);
+    QThreadPool::globalInstance()->start([self, path, compactPath, snapshotSize, budget, liveOffsets]() {
+        QFile source(path);
+        QFile target(compactPath);
+        bool ok = source.open(QIODevice::ReadOnly)
+                  && target.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        const uchar *data = ok ? source.map(0, snapshotSize) : nullptr;
+
+        if (data) {
+            // 从最新的记录往前累计，直到达到预算
+            int first = liveOffsets.size();
+            qint64 total = 0;
+            while (first > 0) {
+                RecordHeader header;
+                if (!readHeader(data, snapshotSize, liveOffsets.at(first - 1), &header)) {
+                    break;
+                }
+                const qint64 length = kHeaderSize + header.keyLength + header.valueLength;
+                if (total + length > budget) {
+                    break;
+                }
+                total += length;
+                --first;
+            }
+
+            // 同时记下记录在新文件中的偏移，压缩后的文件打开时不必重新扫描
+            QHash<quint64, qint64> index;
+            index.reserve(liveOffsets.size() - first);
+            qint64 written = sizeof(kFileMagic);
+            qint64 lastRecord = -1;
+            target.write(kFileMagic, sizeof(kFileMagic));
+            for (int i = first; i < liveOffsets.size() && ok; ++i) {
+                RecordHeader header;
+                readHeader(data, snapshotSize, liveOffsets.at(i), &header);
+                const qint64 length = kHeaderSize + header.keyLength + header.valueLength;
+                ok = target.write(reinterpret_cast<const char *>(data + liveOffsets.at(i)), length) == length;
+                index.insert(header.hash, written);
+                lastRecord = written;
+                written += length;
+            }
+            source.unmap(const_cast<uchar *>(data));
+            if (ok) {
+                writeIndex(indexPath(compactPath), index, written, lastRecord);
+            }
+        } else {
+            ok = false;
+        }
+        target.close();
+
+        if (!self) {
+            QFile::remove(compactPath);
+            QFile::remove(indexPath(compactPath));
+            return;
+        }
+        QMetaObject::invokeMethod(self, [self, ok, compactPath, snapshotSize]() {
+            if (ok) {
+                self->finishCompaction(compactPath, snapshotSize);
+            } else {
+                qWarning() << "Translation store compaction failed";
+                QFile::remove(compactPath);
+                QFile::remove(indexPath(compactPath));
+            }
+            self->m_compacting = false;
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TranslationStore::finishCompaction(const QString &compactPath, qint64 snapshotSize)
+{
+    if (!m_file.isOpen()) {
+        QFile::remove(compactPath);
+        QFile::remove(indexPath(compactPath));
+        return;
+    }
+
+    // 把压缩期间追加的记录接到新文件末尾，它们不在新索引中，重新打开时扫描补上
+    QFile target(compactPath);
+    if (!target.open(QIODevice::Append)) {
+        QFile::remove(compactPath);
+        QFile::remove(indexPath(compactPath));
+        return;
+    }
+    if (m_fileSize > snapshotSize) {
+        m_file.seek(snapshotSize);
+        target.write(m_file.read(m_fileSize - snapshotSize));
+    }
+    target.close();
+
+    const QString path = m_file.fileName();
+    const qint64 maxFileSize = m_maxFileSize;
+    const qint64 before = m_fileSize;
+    closeFile(false);
+
+    // 先删除旧索引：中途失败时新数据文件没有索引，打开时完整扫描
+    QFile::remove(indexPath(path));
+    QFile::remove(path);
+    if (!QFile::rename(compactPath, path)) {
+        qWarning() << "Failed to replace translation store with compacted file";
+    }
+    QFile::rename(indexPath(compactPath), indexPath(path));
+    open(path, maxFileSize);
+
+    qDebug() << "Translation store compacted:" << before << "->" << m_fileSize << "bytes";
+}
+
+bool TranslationStore::isBenchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--store-bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int TranslationStore::benchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Translation store open and lookup benchmark.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("store-bench", "Number of records to write.", "n", "100000");
+    QCommandLineOption queriesOption("queries", "Number of hit and miss lookups.", "n", "100000");
+    parser.addOptions({benchOption, queriesOption});
+    parser.process(arguments);
+
+    const int records = qMax(1, parser.value(benchOption).toInt());
+    const int queries = qMax(1, parser.value(queriesOption).toInt());
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        return 1;
+    }
+    const QString path = dir.filePath("translations.db");
+    const qint64 maxFileSize = qint64(1) << 40;  // 测量期间不触发压缩
+
+    // 与 Translator::cacheKey 使用同一个 makeKey，键为默认地址的服务商和一句话，长度与实际相同
+    auto keyAt = [](int i) {
+        return TranslationCache::makeKey("volcengine", "en", "zh",
+                                         QString("The quick brown fox number %1 jumps over the lazy dog.").arg(i));
+    };
+    QElapsedTimer timer;
+    timer.start();
+    {
+        TranslationStore store;
+        if (!store.open(path, maxFileSize)) {
+            return 1;
+        }
+        for (int i = 0; i < records; ++i) {
+            store.insert(keyAt(i), QString("敏捷的棕色狐狸第 %1 号跳过了那只懒狗。").arg(i));
+        }
+    }
+    const qint64 writeMsecs = timer.elapsed();
+
+    // 关闭时写入了索引文件，先测量载入索引的打开耗时，再删除索引测量完整扫描的耗时
+    qint64 openNsecs = 0;
+    {
+        TranslationStore indexed;
+        timer.start();
+        if (!indexed.open(path, maxFileSize)) {
+            return 1;
+        }
+        openNsecs = timer.nsecsElapsed();
+    }
+    QFile::remove(indexPath(path));
+    timer.start();
+    TranslationStore store;
+    if (!store.open(path, maxFileSize)) {
+        return 1;
+    }
+    const qint64 scanNsecs = timer.nsecsElapsed();
+
+    QRandomGenerator random(20240601);
+    auto measure = [&store, &random, &keyAt, records, queries](int offset, int *found) {
+        QList<qint64> latencies;
+        latencies.reserve(queries);
+        QElapsedTimer lookupTimer;
+        QString result;
+        for (int i = 0; i < queries; ++i) {
+            const QString key = keyAt(offset + int(random.bounded(records)));
+            lookupTimer.start();
+            *found += store.lookup(key, &result) ? 1 : 0;
+            latencies.append(lookupTimer.nsecsElapsed());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        return latencies;
+    };
+    auto line = [](const QList<qint64> &latencies) {
+        auto percentile = [&latencies](double p) {
+            return latencies.at(qBound(0, int(latencies.size() * p), int(latencies.size()) - 1));
+        };
+        return QString("p50 %1 ns  p99 %2 ns  max %3 ns").arg(percentile(0.5)).arg(percentile(0.99)).arg(latencies.last());
+    };
+
+    int hits = 0;
+    int misses = 0;
+    const QList<qint64> hitLatencies = measure(0, &hits);
+    const QList<qint64> missLatencies = measure(records, &misses);
+
+    // 同一进程刚写完文件，页缓存是热的；冷启动数据需要先清空系统缓存再运行
+    QTextStream err(stderr);
+    err << QString("write: %1 records, %2 bytes in %3 ms\n").arg(store.count()).arg(store.fileSize()).arg(writeMsecs);
+    err << QString("open: %1 us with index file, %2 us scanning all records\n")
+               .arg(openNsecs / 1000.0, 0, 'f', 1)
+               .arg(scanNsecs / 1000.0, 0, 'f', 1);
+    err << QString("hit lookups: %1/%2  %3\n").arg(hits).arg(queries).arg(line(hitLatencies));
+    err << QString("miss lookups: %1/%2 found  %3\n").arg(misses).arg(queries).arg(line(missLatencies));
+    err.flush();
+    return hits == queries && misses == 0 ? 0 : 2;
+}
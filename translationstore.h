@@ -0,0 +1,70 @@
+#ifndef TRANSLATIONSTORE_H
+#define TRANSLATIONSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+// 持久化的翻译记录存储：只追加的数据文件 + 内存哈希索引。
+// 数据文件通过内存映射读取。索引在关闭和压缩时写入旁边的 .idx 文件，并记下它覆盖的数据长度，
+// 启动时载入索引后只需扫描之后追加的记录；索引缺失或与数据不符时才遍历全部记录头。
+// 文件超过大小上限后在后台线程中压缩（去掉被覆盖的旧记录）。
+class TranslationStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TranslationStore(QObject *parent = nullptr);
+    ~TranslationStore();
+
+    bool open(const QString &path, qint64 maxFileSize = 64 * 1024 * 1024);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    bool lookup(const QString &key, QString *result);
+    void insert(const QString &key, const QString &result);
+
+    int count() const { return m_index.size(); }
+    qint64 fileSize() const { return m_fileSize; }
+
+    static QString defaultPath();
+
+    // --store-bench：在临时目录生成 n 条记录，测量重新打开和查询的耗时
+    static bool isBenchMode(int argc, char *argv[]);
+    static int benchmark(const QStringList &arguments);
+
+private:
+    struct RecordHeader {
+        quint32 magic;
+        quint32 keyLength;
+        quint32 valueLength;
+        quint32 reserved;
+        quint64 hash;
+    };
+
+    static quint64 hashKey(const QByteArray &key);
+    static bool readHeader(const uchar *data, qint64 size, qint64 offset, RecordHeader *header);
+    static qint64 buildIndex(const uchar *data, qint64 size, qint64 offset,
+                             QHash<quint64, qint64> *index, qint64 *lastRecord);
+    static QString indexPath(const QString &path) { return path + ".idx"; }
+    static bool writeIndex(const QString &path, const QHash<quint64, qint64> &index, qint64 dataSize, qint64 lastRecord);
+    qint64 loadIndex();
+
+    void closeFile(bool saveIndex);
+    bool remap();
+    void startCompaction();
+    void finishCompaction(const QString &compactPath, qint64 snapshotSize);
+
+    QFile m_file;
+    uchar *m_map{nullptr};
+    qint64 m_mappedSize{0};
+    qint64 m_fileSize{0};
+    qint64 m_maxFileSize{0};
+    bool m_compacting{false};
+    QHash<quint64, qint64> m_index;  // 键哈希 -> 最新记录偏移
+    qint64 m_lastRecord{-1};         // 最后一条记录的偏移，写入索引文件用于校验
+    qint64 m_indexedSize{-1};        // 索引文件覆盖的数据长度，与 m_fileSize 相同时关闭时不必重写
+};
+
+#endif // TRANSLATIONSTORE_H
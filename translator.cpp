@@ -0,0 +1,1184 @@
+#include "translator.h"
+#include "allocationcounter.h"
+#include "languagedetector.h"
+#include "markuptokenizer.h"
+#include "requesttemplate.h"
+#include "textsegmenter.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrl>
+#include <QtMath>
+#include <cstring>
+
+namespace {
+const int kMinLatencySamples = 5;       // 样本不足时使用默认对冲延迟
+const int kDefaultHedgeDelay = 1500;    // 毫秒
+const int kDefaultTimeout = 15000;      // 毫秒
+
+// 请求模板之前的实现：逐字段构建 QJsonObject 再序列化，作为 --encode-bench 的对照
+QByteArray jsonRequestV1(const QStringList &texts, const QString &sourceLang, const QString &targetLang)
+{
+    QJsonObject json;
+    json["source_language"] = sourceLang;
+    json["target_language"] = targetLang;
+    json["text_list"] = QJsonArray::fromStringList(texts);
+    json["glossary_list"] = QJsonArray();
+    json["enable_user_glossary"] = false;
+    json["category"] = "";
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+QByteArray jsonRequestV2(const QStringList &texts, const QString &sourceLang, const QString &targetLang)
+{
+    QJsonObject source;
+    source["lang"] = sourceLang;
+    source["text_list"] = QJsonArray::fromStringList(texts);
+
+    QJsonObject target;
+    target["lang"] = targetLang;
+
+    QJsonObject header;
+    header["fn"] = "auto_translation";
+    header["session"] = "";
+    header["client_key"] = "browser-chrome-131.0.0";
+    header["user"] = "";
+
+    QJsonObject json;
+    json["header"] = header;
+    json["type"] = "plain";
+    json["model_category"] = "normal";
+    json["text_domain"] = "general";
+    json["source"] = source;
+    json["target"] = target;
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+}
+
+Translator::Translator(QObject *parent)
+    : QObject{parent}
+{
+    connect(&http, &HttpManager::sig_dataReceived, this, &Translator::dataReceived);
+    connect(&http, &HttpManager::sig_finished, this, &Translator::finished);
+    http.setStreaming(m_streamingDecoder);
+    m_decodePool.setMaxThreadCount(1);
+}
+
+bool Translator::isBenchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--encode-bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int Translator::benchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Request body encoding benchmark: QJsonDocument against request templates.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("encode-bench", "Request bodies rendered per encoder.", "n", "20000");
+    QCommandLineOption sentencesOption("sentences", "Sentences per request body.", "n", "8");
+    parser.addOptions({benchOption, sentencesOption});
+    parser.process(arguments);
+
+    const int count = qMax(1, parser.value(benchOption).toInt());
+    const int sentences = qMax(1, parser.value(sentencesOption).toInt());
+    QTextStream err(stderr);
+    if (!AllocationCounter::isSupported()) {
+        err << "allocation counts need a build configured with -DTRANSLATE_ALLOCATION_COUNTER=ON\n";
+    }
+
+    // 每个请求体的句子各不相同，混合中文、引号、反斜杠和控制字符，覆盖转义路径
+    const QStringList samples = {
+        QStringLiteral("The quick brown fox jumps over the lazy dog."),
+        QStringLiteral("这是一段用于测试请求体构建速度的中文句子。"),
+        QStringLiteral("He said \"hello\" and left C:\\temp\tbehind."),
+        QStringLiteral("Café, naïve, déjà vu — 混合文本 with emoji 🙂."),
+    };
+    QList<QStringList> inputs;
+    inputs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QStringList texts;
+        for (int j = 0; j < sentences; ++j) {
+            texts.append(samples.at((i + j) % samples.size()) + QString::number(i * sentences + j));
+        }
+        inputs.append(texts);
+    }
+
+    using Encoder = QByteArray (*)(const QStringList &, const QString &, const QString &);
+    auto measure = [&inputs](Encoder encode, qint64 *bytes) {
+        const quint64 allocations = AllocationCounter::count();
+        QElapsedTimer timer;
+        timer.start();
+        qint64 total = 0;
+        for (const QStringList &texts : std::as_const(inputs)) {
+            total += encode(texts, "en", "zh").size();
+        }
+        const double nsecs = timer.nsecsElapsed();
+        *bytes = total;
+        return QString("%1 ns/request  %2 allocs/request")
+            .arg(nsecs / inputs.size(), 0, 'f', 0)
+            .arg(AllocationCounter::isSupported()
+                     ? QString::number(double(AllocationCounter::count() - allocations) / inputs.size(), 'f', 1)
+                     : QString("n/a"));
+    };
+
+    const struct {
+        const char *name;
+        Encoder json;
+        Encoder render;
+    } providers[] = {
+        {"volcengine", jsonRequestV1, Translation_v1},
+        {"tencent", jsonRequestV2, Translation_v2},
+    };
+    for (const auto &provider : providers) {
+        // 两种实现的键顺序不同，解析后比较内容
+        const QStringList &first = inputs.first();
+        if (QJsonDocument::fromJson(provider.json(first, "en", "zh"))
+            != QJsonDocument::fromJson(provider.render(first, "en", "zh"))) {
+            err << provider.name << ": request template output differs from QJsonDocument\n";
+            err.flush();
+            return 2;
+        }
+
+        // 先各跑一轮预热，再交替测量
+        qint64 bytes = 0;
+        measure(provider.json, &bytes);
+        measure(provider.render, &bytes);
+        const QString json = measure(provider.json, &bytes);
+        const QString render = measure(provider.render, &bytes);
+        err << QString("%1: %2 requests x %3 sentences, %4 bytes/request\n")
+                   .arg(provider.name)
+                   .arg(count)
+                   .arg(sentences)
+                   .arg(bytes / count);
+        err << "  QJsonDocument:   " << json << "\n";
+        err << "  RequestTemplate: " << render << "\n";
+    }
+    err.flush();
+    return 0;
+}
+
+void Translator::setStreamingDecoder(bool enabled)
+{
+    m_streamingDecoder = enabled;
+    http.setStreaming(enabled);
+}
+
+QString Translator::codecSummary(const QString &label, const CodecStats &stats)
+{
+    const double ms = stats.nsecs / 1e6;
+    const double average = stats.count ? stats.nsecs / 1e3 / stats.count : 0;
+    const double mbPerSec = stats.nsecs ? stats.bytes * 1e3 / stats.nsecs : 0;
+    return QString("%1 %2 次  %3 KB  %4 ms  平均 %5 us  %6 MB/s")
+        .arg(label)
+        .arg(stats.count)
+        .arg(stats.bytes / 1024)
+        .arg(ms, 0, 'f', 1)
+        .arg(average, 0, 'f', 1)
+        .arg(mbPerSec, 0, 'f', 1);
+}
+
+QString Translator::encodeSummary() const
+{
+    return codecSummary("构建请求", m_encodeStats);
+}
+
+QString Translator::decodeSummary() const
+{
+    return codecSummary(m_streamingDecoder ? "流式解码" : "QJsonDocument", m_decodeStats);
+}
+
+QString Translator::providerName(API_VERSION version)
+{
+    switch (version) {
+    case API_VERSION::V1:
+        return "volcengine";
+    case API_VERSION::V2:
+        return "tencent";
+    default:
+        return QString();
+    }
+}
+
+API_VERSION Translator::otherProvider(API_VERSION version)
+{
+    return version == API_VERSION::V1 ? API_VERSION::V2 : API_VERSION::V1;
+}
+
+QString Translator::defaultProviderUrl(API_VERSION version)
+{
+    switch (version) {
+    case API_VERSION::V1:
+        return "https://translate.volcengine.com/crx/translate/v2/";
+    case API_VERSION::V2:
+        return "https://yi.qq.com/api/imt";
+    default:
+        return QString();
+    }
+}
+
+void Translator::setBaseUrl(API_VERSION version, const QString &baseUrl)
+{
+    const QUrl base(baseUrl);
+    if (baseUrl.isEmpty() || !base.isValid()) {
+        m_providerUrls.remove(version);
+        m_preparedRequests.remove(version);
+        setRateLimit(version, m_rateLimits.value(version));
+        setRequestCompression(version, m_compressRequests.value(version));
+        return;
+    }
+
+    QUrl url(defaultProviderUrl(version));
+    url.setScheme(base.scheme());
+    url.setHost(base.host());
+    url.setPort(base.port());
+    m_providerUrls.insert(version, url.toString());
+    m_preparedRequests.remove(version);
+    setRateLimit(version, m_rateLimits.value(version));
+    setRequestCompression(version, m_compressRequests.value(version));
+}
+
+void Translator::setRequestCompression(API_VERSION version, bool enabled)
+{
+    m_compressRequests.insert(version, enabled);
+    http.setHostRequestCompression(QUrl(providerUrl(version)).host(), enabled);
+}
+
+void Translator::setRateLimit(API_VERSION version, double requestsPerSecond)
+{
+    // 允许一秒内的请求集中发出
+    m_rateLimits.insert(version, requestsPerSecond);
+    http.setHostRateLimit(QUrl(providerUrl(version)).host(), requestsPerSecond, qMax(1, qCeil(requestsPerSecond)));
+}
+
+QString Translator::providerUrl(API_VERSION version) const
+{
+    return m_providerUrls.value(version, defaultProviderUrl(version));
+}
+
+QNetworkRequest Translator::preparedRequest(API_VERSION version)
+{
+    auto it = m_preparedRequests.constFind(version);
+    if (it == m_preparedRequests.constEnd()) {
+        it = m_preparedRequests.insert(version, http.prepareRequest(providerUrl(version), requestHeaders(version)));
+    }
+    return *it;
+}
+
+void Translator::preconnect()
+{
+    const API_VERSION primary = selectProvider();
+    http.preconnect(providerUrl(primary));
+    if (m_hedging) {
+        http.preconnect(providerUrl(otherProvider(primary)));
+    }
+}
+
+API_VERSION Translator::selectProvider() const
+{
+    if (!m_autoSelect) {
+        return m_apiVersion;
+    }
+
+    // 两个服务商都有足够样本且健康时选 EWMA 延迟更低的，否则避开不健康的
+    const API_VERSION other = otherProvider(m_apiVersion);
+    const ProviderStats primary = m_stats.value(m_apiVersion);
+    const ProviderStats backup = m_stats.value(other);
+    if (!primary.isHealthy() && backup.isHealthy()) {
+        return other;
+    }
+    if (primary.isHealthy() && backup.isHealthy()
+        && primary.sampleCount() >= kMinLatencySamples && backup.sampleCount() >= kMinLatencySamples
+        && backup.ewmaLatency() < primary.ewmaLatency()) {
+        return other;
+    }
+    return m_apiVersion;
+}
+
+void Translator::languages(API_VERSION version, const QString &language, QString *sourceLang, QString *targetLang)
+{
+    // 中文译为英文，其他语言译为中文；拉丁字母等无法确定语言时火山自动识别，腾讯按英文处理
+    *targetLang = language == "zh" ? "en" : "zh";
+    if (!language.isEmpty()) {
+        *sourceLang = language;
+    } else {
+        *sourceLang = version == API_VERSION::V1 ? "detect" : "en";
+    }
+}
+
+QString Translator::cacheKey(API_VERSION version, const QString &language, const QString &text) const
+{
+    QString sourceLang, targetLang;
+    languages(version, language, &sourceLang, &targetLang);
+
+    // 覆盖了接口地址（如本地模拟服务）时带上主机和端口，避免其结果被当作真实服务商的译文复用
+    QString provider = providerName(version);
+    if (m_providerUrls.contains(version)) {
+        provider += "@" + QUrl(m_providerUrls.value(version)).authority();
+    }
+    return TranslationCache::makeKey(provider, sourceLang, targetLang, text);
+}
+
+quint64 Translator::createJob(const QString &source, quint64 traceId)
+{
+    // HTML、Markdown 和代码中的标签、网址、代码只保留原样，自然语言部分才切句发送
+    QList<MarkupSpan> spans = m_markupAware ? MarkupTokenizer::tokenize(source)
+                                            : QList<MarkupSpan>{{source, true}};
+    QString prose;
+    for (MarkupSpan &span : spans) {
+        m_payloadStats.sourceBytes += utf8Length(span.text);
+        if (!span.translatable) {
+            m_payloadStats.verbatimBytes += utf8Length(span.text);
+            continue;
+        }
+        if (m_repairLineBreaks) {
+            span.text = TextSegmenter::repairLineBreaks(span.text);
+        }
+        prose += span.text;
+    }
+
+    Job job;
+    job.apiVersion = selectProvider();
+    job.traceId = traceId;
+
+    // 按全部自然语言文本判断语言，保证各批次的翻译方向一致
+    job.language = LanguageDetector::detect(prose).language;
+
+    // 以句子为单位缓存和发送，再把相邻的句子合并成不超过 chunkSize 的批次；
+    // 原样保留的片段不发送，不计入批次大小
+    QList<TextSegment> sentences;
+    for (const MarkupSpan &span : std::as_const(spans)) {
+        if (span.translatable) {
+            sentences += TextSegmenter::sentences(span.text);
+        } else {
+            sentences.append(TextSegment{span.text, QString(), true});
+        }
+    }
+
+    Chunk chunk;
+    int chunkChars = 0;
+    for (const TextSegment &sentence : std::as_const(sentences)) {
+        if (sentence.verbatim) {
+            chunk.units.append(sentence);
+            chunk.results.append(QString());
+            continue;
+        }
+
+        // 超长的句子按字符数切开，原句后的分隔符跟在最后一段后面
+        QList<TextSegment> pieces{sentence};
+        if (sentence.text.size() > m_chunkSize) {
+            pieces = TextSegmenter::split(sentence.text, m_chunkSize);
+            pieces.last().separator += sentence.separator;
+        }
+
+        for (const TextSegment &piece : std::as_const(pieces)) {
+            const int chars = piece.text.size() + piece.separator.size();
+            if (chunkChars > 0 && chunkChars + chars > m_chunkSize) {
+                job.chunks.append(chunk);
+                chunk = Chunk();
+                chunkChars = 0;
+            }
+            // 句内连续的空白合并为一个空格再发送和缓存；无需翻译的片段保持原样
+            TextSegment unit = piece;
+            if (!TextSegmenter::isTrivial(unit.text)) {
+                unit.text = unit.text.simplified();
+            }
+            chunk.units.append(unit);
+            chunk.results.append(QString());
+            chunkChars += chars;
+        }
+    }
+    if (!chunk.units.isEmpty()) {
+        job.chunks.append(chunk);
+    }
+    job.remaining = job.chunks.size();
+    m_tracer.setLabel(traceId, providerName(job.apiVersion));
+    m_tracer.mark(traceId, LatencyTracer::JobCreated);
+
+    const quint64 jobId = m_nextJobId++;
+    m_jobs.insert(jobId, job);
+    return jobId;
+}
+
+int Translator::chunkCount(quint64 jobId) const
+{
+    auto it = m_jobs.constFind(jobId);
+    return it == m_jobs.constEnd() ? 0 : it->chunks.size();
+}
+
+void Translator::start(quint64 jobId)
+{
+    if (!m_jobs.contains(jobId)) {
+        return;
+    }
+
+    if (m_jobs[jobId].chunks.isEmpty()) {
+        m_jobs.remove(jobId);
+        emit sig_jobFinished(jobId, false);
+        return;
+    }
+
+    // 先同步返回缓存命中的批次，不访问网络；对冲模式下另一服务商的结果同样可用
+    QList<API_VERSION> providers{m_jobs[jobId].apiVersion};
+    if (m_hedging) {
+        providers.append(otherProvider(providers.first()));
+    }
+
+    // 只改动了部分句子时，未改动的句子直接复用上次的译文
+    const int count = m_jobs[jobId].chunks.size();
+    const double roundTrip = m_stats.value(providers.first()).ewmaLatency();
+    for (int i = 0; i < count; ++i) {
+        auto it = m_jobs.find(jobId);
+        if (it == m_jobs.end()) {
+            return;
+        }
+
+        Chunk &chunk = it->chunks[i];
+        for (int u = 0; u < chunk.units.size(); ++u) {
+            const QString &text = chunk.units[u].text;
+            if (text.isEmpty()) {
+                chunk.results[u] = QStringLiteral("");
+            } else if (chunk.units[u].verbatim) {
+                chunk.results[u] = text;
+            } else if (TextSegmenter::isTrivial(text)) {
+                chunk.results[u] = text;
+                ++m_payloadStats.trivialSegments;
+            } else if (lookupCached(providers, it->language, text, &chunk.results[u])) {
+                ++m_reuseStats.reusedSegments;
+                m_reuseStats.reusedBytes += utf8Length(text);
+            } else {
+                chunk.missing.append(u);
+            }
+        }
+
+        // 重复的句子只发送一次，译文返回后按 textIndex 展开到每个位置
+        QHash<QString, int> unique;
+        for (int u : std::as_const(chunk.missing)) {
+            const QString &text = chunk.units[u].text;
+            auto slot = unique.constFind(text);
+            if (slot == unique.constEnd()) {
+                slot = unique.insert(text, chunk.texts.size());
+                chunk.texts.append(text);
+                m_payloadStats.sentTextBytes += utf8Length(text);
+            } else {
+                ++m_payloadStats.duplicateSegments;
+            }
+            chunk.textIndex.append(*slot);
+        }
+
+        if (chunk.missing.isEmpty()) {
+            // 整个批次都命中时省去一次请求往返
+            m_reuseStats.savedMs += roundTrip;
+            finishChunk(jobId, i, true);
+        }
+    }
+
+    pump(jobId);
+}
+
+bool Translator::lookupCached(const QList<API_VERSION> &providers, const QString &language,
+                              const QString &text, QString *result)
+{
+    for (API_VERSION version : providers) {
+        const QString key = cacheKey(version, language, text);
+        if (m_cache.lookup(key, result)) {
+            return true;
+        }
+        if (m_store.lookup(key, result)) {
+            // 持久化存储命中后回填内存缓存
+            m_cache.insert(key, *result);
+            return true;
+        }
+    }
+    return false;
+}
+
+qsizetype Translator::utf8Length(QStringView text)
+{
+    qsizetype length = 0;
+    for (QChar ch : text) {
+        const char16_t c = ch.unicode();
+        // 代理对的两个单元合计 4 字节
+        length += c < 0x80 ? 1 : (c < 0x800 || QChar::isSurrogate(c) ? 2 : 3);
+    }
+    return length;
+}
+
+QString Translator::payloadSummary() const
+{
+    const quint64 source = m_payloadStats.sourceBytes;
+    const double shrink = source ? 100.0 * (1.0 - double(m_payloadStats.sentTextBytes) / source) : 0;
+    return QString("原文 %1 KB  发送文本 %2 KB（缩减 %3%）  重复 %4 句  跳过 %5 句  保留标记/代码 %6 KB")
+        .arg(source / 1024)
+        .arg(m_payloadStats.sentTextBytes / 1024)
+        .arg(shrink, 0, 'f', 1)
+        .arg(m_payloadStats.duplicateSegments)
+        .arg(m_payloadStats.trivialSegments)
+        .arg(m_payloadStats.verbatimBytes / 1024);
+}
+
+QString Translator::reuseSummary() const
+{
+    return QString("句子复用 %1（%2 KB）  发送 %3（%4 KB）  节省约 %5 ms")
+        .arg(m_reuseStats.reusedSegments)
+        .arg(m_reuseStats.reusedBytes / 1024)
+        .arg(m_reuseStats.sentSegments)
+        .arg(m_reuseStats.sentBytes / 1024)
+        .arg(qRound64(m_reuseStats.savedMs));
+}
+
+void Translator::cancel(quint64 jobId)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    for (const Chunk &chunk : it->chunks) {
+        for (quint64 requestId : chunk.requestIds) {
+            dropRequest(requestId);
+        }
+    }
+    m_tracer.discard(it->traceId);
+    m_jobs.erase(it);
+}
+
+void Translator::pump(quint64 jobId)
+{
+    auto it = m_jobs.find(jobId);
+    while (it != m_jobs.end() && it->inFlight < m_maxInFlight && it->nextChunk < it->chunks.size()) {
+        const int index = it->nextChunk++;
+        if (it->chunks[index].done) {
+            continue;
+        }
+
+        ++it->inFlight;
+        sendChunk(jobId, index, it->apiVersion);
+
+        if (m_hedging) {
+            // 已完成或已对冲的批次在 hedge 中会被忽略，无需取消定时器
+            QTimer::singleShot(hedgeDelay(it->apiVersion), this, [this, jobId, index]() {
+                hedge(jobId, index);
+            });
+        }
+    }
+}
+
+void Translator::runTask(const std::function<void()> &task)
+{
+    if (m_pipeline) {
+        QThreadPool::globalInstance()->start(task);
+    } else {
+        task();
+    }
+}
+
+void Translator::runDecodeTask(const std::function<void()> &task)
+{
+    if (m_pipeline) {
+        m_decodePool.start(task);
+    } else {
+        task();
+    }
+}
+
+void Translator::sendChunk(quint64 jobId, int index, API_VERSION version)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    QString sourceLang, targetLang;
+    languages(version, it->language, &sourceLang, &targetLang);
+    Chunk &chunk = it->chunks[index];
+    const int single = chunk.single;
+    const QStringList texts = single >= 0 ? QStringList{chunk.texts.at(single)} : chunk.texts;
+    ++chunk.pending;
+    m_reuseStats.sentSegments += texts.size();
+
+    // 在线程池中序列化请求体，完成后回到本线程发送
+    QPointer<Translator> self(this);
+    runTask([self, jobId, index, version, single, texts, sourceLang, targetLang]() {
+        QElapsedTimer timer;
+        timer.start();
+        const QByteArray body = version == API_VERSION::V1 ? Translation_v1(texts, sourceLang, targetLang)
+                                                           : Translation_v2(texts, sourceLang, targetLang);
+        const qint64 nsecs = timer.nsecsElapsed();
+        if (self) {
+            QMetaObject::invokeMethod(self, [self, jobId, index, version, single, body, nsecs]() {
+                ++self->m_encodeStats.count;
+                self->m_encodeStats.bytes += body.size();
+                self->m_reuseStats.sentBytes += body.size();
+                self->m_encodeStats.nsecs += nsecs;
+                self->dispatchChunk(jobId, index, version, single, body);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void Translator::dispatchChunk(quint64 jobId, int index, API_VERSION version, int single, const QByteArray &body)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end() || it->chunks[index].done) {
+        return;
+    }
+
+    Chunk &chunk = it->chunks[index];
+    if (single != chunk.single) {
+        // 构建请求体期间已改为逐句重发或已进入下一句
+        staleAttempt(jobId, index);
+        return;
+    }
+    const HttpManager::Priority priority = m_priority == HttpManager::Interactive && (index == 0 || chunk.hedged)
+                                               ? HttpManager::Interactive
+                                               : HttpManager::Bulk;
+    const quint64 requestId = http.sendPostRequest(preparedRequest(version), body, priority);
+    if (requestId == 0) {
+        --chunk.pending;
+        attemptFailed(jobId, index);
+        return;
+    }
+
+    Request request;
+    request.jobId = jobId;
+    request.index = index;
+    request.apiVersion = version;
+    request.single = single;
+    request.elapsed.start();
+    m_requests.insert(requestId, request);
+    chunk.requestIds.append(requestId);
+    m_tracer.mark(it->traceId, LatencyTracer::RequestSent);
+
+    if (m_streamingDecoder) {
+        auto state = QSharedPointer<StreamDecode>::create();
+        watchResponse(version, &state->decoder);
+        m_decoders.insert(requestId, state);
+    }
+}
+
+void Translator::dropRequest(quint64 requestId)
+{
+    http.abort(requestId);
+    m_requests.remove(requestId);
+    m_decoders.remove(requestId);
+}
+
+void Translator::abortAttempts(Chunk *chunk)
+{
+    // 只取消仍在网络上的请求；已返回、正在解析的请求稍后作为过期结果丢弃
+    for (quint64 requestId : std::as_const(chunk->requestIds)) {
+        dropRequest(requestId);
+        --chunk->pending;
+    }
+    chunk->requestIds.clear();
+}
+
+void Translator::markStage(quint64 jobId, LatencyTracer::Stage stage)
+{
+    auto it = m_jobs.constFind(jobId);
+    if (it != m_jobs.constEnd()) {
+        m_tracer.mark(it->traceId, stage);
+    }
+}
+
+void Translator::attemptFailed(quint64 jobId, int index)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Chunk &chunk = it->chunks[index];
+    if (chunk.done || chunk.pending > 0) {
+        // 另一服务商的尝试仍在进行，等待它的结果
+        return;
+    }
+
+    if (m_hedging && !chunk.hedged) {
+        // 主服务商失败时立即改用另一服务商
+        hedge(jobId, index);
+        return;
+    }
+
+    --it->inFlight;
+    finishChunk(jobId, index, false);
+    pump(jobId);
+}
+
+void Translator::staleAttempt(quint64 jobId, int index)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    // 当前句子成功时会立即发出下一句；没有其他尝试时说明当前句子已失败，正在等待本次结束
+    Chunk &chunk = it->chunks[index];
+    if (--chunk.pending == 0) {
+        attemptFailed(jobId, index);
+    }
+}
+
+void Translator::hedge(quint64 jobId, int index)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Chunk &chunk = it->chunks[index];
+    if (chunk.done || chunk.hedged) {
+        return;
+    }
+    chunk.hedged = true;
+
+    const API_VERSION backup = otherProvider(it->apiVersion);
+    qDebug() << "Hedging chunk" << index << "to" << providerName(backup);
+    sendChunk(jobId, index, backup);
+}
+
+void Translator::recordResult(API_VERSION version, HttpManager::RequestStatus status, bool ok, qint64 ms)
+{
+    ProviderStats &stats = m_stats[version];
+    if (ok) {
+        stats.recordSuccess(ms);
+    } else if (status == HttpManager::TimedOut) {
+        stats.recordTimeout();
+    } else {
+        stats.recordError();
+    }
+
+    // 根据最新统计调整该服务商的超时时间
+    http.setHostTimeout(QUrl(providerUrl(version)).host(), stats.adaptiveTimeout(kDefaultTimeout));
+}
+
+int Translator::hedgeDelay(API_VERSION version) const
+{
+    const ProviderStats stats = m_stats.value(version);
+    if (stats.sampleCount() < kMinLatencySamples) {
+        return kDefaultHedgeDelay;
+    }
+    return int(stats.percentile(0.9));
+}
+
+void Translator::finishChunk(quint64 jobId, int index, bool ok)
+{
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Chunk &chunk = it->chunks[index];
+    if (chunk.done) {
+        return;
+    }
+    chunk.done = true;
+    if (!ok) {
+        it->failed = true;
+    }
+
+    // 先返回的结果胜出，取消另一服务商上仍在进行的请求
+    for (quint64 requestId : chunk.requestIds) {
+        dropRequest(requestId);
+    }
+    chunk.requestIds.clear();
+
+    // 每句译文后拼接原文中的分隔空白，调用方按序号直接拼接即可还原格式；
+    // 译为中文时句间的空格没有意义，只保留换行
+    const bool toChinese = it->language != "zh";
+    QString text;
+    for (int u = 0; u < chunk.units.size(); ++u) {
+        const QString &separator = chunk.units[u].separator;
+        text += chunk.results[u];
+        if (!toChinese || separator.contains('\n')) {
+            text += separator;
+        }
+    }
+    const bool jobDone = --it->remaining == 0;
+    const bool jobOk = !it->failed;
+    if (jobDone) {
+        m_jobs.erase(it);
+    }
+
+    emit sig_chunkFinished(jobId, index, text);
+    if (jobDone) {
+        emit sig_jobFinished(jobId, jobOk);
+    }
+}
+
+void Translator::dataReceived(quint64 requestId, QByteArray data, bool first)
+{
+    auto it = m_decoders.constFind(requestId);
+    if (it == m_decoders.constEnd()) {
+        return;
+    }
+    if (first) {
+        markStage(m_requests.value(requestId).jobId, LatencyTracer::FirstByte);
+    }
+
+    // 在解码线程上随到随解析，GUI 线程只负责转交数据
+    const QSharedPointer<StreamDecode> state = *it;
+    runDecodeTask([state, data, first]() {
+        // 重试后从头解析新的响应
+        if (first) {
+            state->decoder.reset();
+        }
+        QElapsedTimer timer;
+        timer.start();
+        state->decoder.feed(data);
+        state->nsecs += timer.nsecsElapsed();
+        state->bytes += data.size();
+    });
+}
+
+void Translator::finished(quint64 requestId, QByteArray data, HttpManager::RequestStatus status)
+{
+    const QSharedPointer<StreamDecode> state = m_decoders.take(requestId);
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) {
+        return;
+    }
+    // 服务商延迟在回复结束时读取；解析要在线程池排队，之后再读会把本地排队时间算进对冲延迟和超时
+    Request request = *it;
+    request.latencyMs = request.elapsed.elapsed();
+    m_requests.erase(it);
+
+    auto job = m_jobs.find(request.jobId);
+    if (job == m_jobs.end()) {
+        return;
+    }
+    job->chunks[request.index].requestIds.removeOne(requestId);
+    m_tracer.mark(job->traceId, LatencyTracer::ReplyFinished);
+
+    QPointer<Translator> self(this);
+    if (m_streamingDecoder && data.isEmpty()) {
+        // 流式模式下数据已在到达时解析，排在同一解码线程上的最后一段之后取出结果
+        runDecodeTask([self, state, request, status]() {
+            QStringList results;
+            const bool ok = status == HttpManager::Succeeded && state
+                            && decodeResponse(request.apiVersion, state->decoder, &results);
+            const qint64 nsecs = state ? state->nsecs : 0;
+            const qint64 bytes = state ? state->bytes : 0;
+            if (self) {
+                QMetaObject::invokeMethod(self, [self, request, status, ok, results, bytes, nsecs]() {
+                    if (status == HttpManager::Succeeded) {
+                        ++self->m_decodeStats.count;
+                        self->m_decodeStats.bytes += bytes;
+                        self->m_decodeStats.nsecs += nsecs;
+                    }
+                    self->chunkParsed(request, status, ok, results);
+                }, Qt::QueuedConnection);
+            }
+        });
+        return;
+    }
+
+    // 在线程池中按实际返回结果的服务商解析，只把译文交回本线程
+    runTask([self, request, data, status]() {
+        QElapsedTimer timer;
+        timer.start();
+        QStringList results;
+        const bool ok = status == HttpManager::Succeeded && parseResponse(request.apiVersion, data, &results);
+        const qint64 nsecs = timer.nsecsElapsed();
+        if (self) {
+            QMetaObject::invokeMethod(self, [self, request, status, ok, results, data, nsecs]() {
+                if (status == HttpManager::Succeeded) {
+                    ++self->m_decodeStats.count;
+                    self->m_decodeStats.bytes += data.size();
+                    self->m_decodeStats.nsecs += nsecs;
+                }
+                self->chunkParsed(request, status, ok, results);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void Translator::chunkParsed(const Request &request, HttpManager::RequestStatus status, bool ok, const QStringList &results)
+{
+    recordResult(request.apiVersion, status, ok, request.latencyMs);
+
+    auto it = m_jobs.find(request.jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+    Chunk &chunk = it->chunks[request.index];
+    if (chunk.done) {
+        return;
+    }
+    if (request.single != chunk.single) {
+        // 改为逐句重发之前的整批请求，或被另一服务商抢先完成的单句请求，结果不再使用
+        staleAttempt(request.jobId, request.index);
+        return;
+    }
+    --chunk.pending;
+
+    if (!ok) {
+        attemptFailed(request.jobId, request.index);
+        return;
+    }
+    m_tracer.mark(it->traceId, LatencyTracer::Parsed);
+
+    // 一句被拆成多段译文时按服务商的习惯拼回：腾讯各段直接相连，火山译为英文时以空格分隔
+    const QString separator = request.apiVersion == API_VERSION::V1 && it->language == "zh" ? QStringLiteral(" ")
+                                                                                           : QString();
+    QStringList translations = results;
+    if (chunk.single >= 0) {
+        chunk.singleResults[chunk.single] = results.join(separator);
+        if (++chunk.single < chunk.texts.size()) {
+            // 这句已有译文，另一服务商上同一句的对冲请求不再需要，取消后才发下一句
+            abortAttempts(&chunk);
+            sendChunk(request.jobId, request.index, request.apiVersion);
+            return;
+        }
+        translations = chunk.singleResults;
+    } else if (results.size() != chunk.texts.size()) {
+        if (chunk.texts.size() > 1) {
+            // 服务商的断句与本地不同，无法把译文对应到句子；逐句重发，每句都能正常缓存
+            qWarning() << "Expected" << chunk.texts.size() << "translations, got" << results.size()
+                       << ", resending sentences one by one";
+            abortAttempts(&chunk);
+            chunk.single = 0;
+            chunk.singleResults = QStringList(chunk.texts.size());
+            sendChunk(request.jobId, request.index, request.apiVersion);
+            return;
+        }
+        translations = QStringList{results.join(separator)};
+    }
+
+    // 逐句写入缓存，下次只改动部分句子时其余句子可以直接复用
+    for (int i = 0; i < chunk.missing.size(); ++i) {
+        chunk.results[chunk.missing.at(i)] = translations.at(chunk.textIndex.at(i));
+    }
+    for (int i = 0; i < translations.size(); ++i) {
+        const QString key = cacheKey(request.apiVersion, it->language, chunk.texts.at(i));
+        m_cache.insert(key, translations.at(i));
+        m_store.insert(key, translations.at(i));
+    }
+    chunk.missing.clear();
+    chunk.texts.clear();
+    chunk.textIndex.clear();
+
+    --it->inFlight;
+    finishChunk(request.jobId, request.index, ok);
+    pump(request.jobId);
+}
+
+QByteArray Translator::Translation_v1(const QStringList &texts, const QString &sourceLang, const QString &targetLang)
+{
+    // 固定字段只解析一次，每句作为 text_list 的一个元素
+    static const RequestTemplate body(R"({"source_language":"%1","target_language":"%2","text_list":[%3],)"
+                                      R"("glossary_list":[],"enable_user_glossary":false,"category":""})");
+
+    return body.render({sourceLang.toLatin1(), targetLang.toLatin1(), RequestTemplate::stringArray(texts)});
+}
+
+QByteArray Translator::Translation_v2(const QStringList &texts, const QString &sourceLang, const QString &targetLang)
+{
+    static const RequestTemplate body(R"({"header":{"fn":"auto_translation","session":"","client_key":"browser-chrome-131.0.0","user":""},)"
+                                      R"("type":"plain","model_category":"normal","text_domain":"general",)"
+                                      R"("source":{"lang":"%1","text_list":[%3]},"target":{"lang":"%2"}})");
+
+    return body.render({sourceLang.toLatin1(), targetLang.toLatin1(), RequestTemplate::stringArray(texts)});
+}
+
+QMap<QString, QString> Translator::requestHeaders(API_VERSION version)
+{
+    QMap<QString, QString> headers;
+    headers["User-Agent"] = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/131.0.0.0 Safari/537.36";
+    headers["content-type"] = "application/json";
+    if (version == API_VERSION::V2) {
+        headers["Accept"] = "application/json, text/plain, */*";
+        headers["Origin"] = "https://yi.qq.com";
+        headers["Referer"] = "https://yi.qq.com/";
+    }
+    return headers;
+}
+
+bool Translator::parseResponse(API_VERSION version, const QByteArray &data, QStringList *results)
+{
+    if (data.isEmpty()) {
+        qWarning() << "Received empty response from server";
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qWarning() << "JSON parse error:" << parseError.errorString();
+        return false;
+    }
+
+    QJsonObject json = jsonDoc.object();
+
+    switch (version) {
+    case API_VERSION::V1: {
+        // 处理火山翻译 API 响应
+        // 检查新的响应格式
+        if (json.contains("translations")) {
+            QJsonObject baseResp = json["base_resp"].toObject();
+            if (baseResp["status_code"].toInt() != 0) {
+                qWarning() << "Translation failed, error code:" << baseResp["status_code"].toInt()
+                          << "message:" << baseResp["status_message"].toString();
+                return false;
+            }
+
+            QJsonArray translations = json["translations"].toArray();
+            if (translations.isEmpty()) {
+                qWarning() << "No translations in response";
+                qDebug() << "Full response object:" << json;
+                return false;
+            }
+
+            for (const QJsonValue &value : translations) {
+                if (!value.isString()) continue;
+                results->append(value.toString());
+            }
+        }
+        // 兼容旧的响应格式
+        else if (json.contains("code")) {
+            int code = json["code"].toInt();
+            if (code != 0) {
+                qWarning() << "Translation failed, error code:" << code 
+                          << "message:" << json["message"].toString();
+                return false;
+            }
+
+            QJsonObject data = json["data"].toObject();
+            QJsonArray translatedTextList = data["translated_text_list"].toArray();
+            
+            if (translatedTextList.isEmpty()) {
+                qWarning() << "No translations in response";
+                qDebug() << "Full response object:" << json;
+                return false;
+            }
+
+            for (const QJsonValue &value : translatedTextList) {
+                if (!value.isString()) continue;
+                results->append(value.toString());
+            }
+        }
+        else {
+            qWarning() << "Unknown V1 API response format";
+            qDebug() << "Full response object:" << json;
+            return false;
+        }
+        break;
+    }
+    case API_VERSION::V2: {
+        // 处理腾讯翻译 API 响应
+        QJsonObject header = json["header"].toObject();
+        if (header["ret_code"].toString() != "succ") {
+            qWarning() << "Translation failed, error code:" << header["ret_code"].toString();
+            return false;
+        }
+
+        QJsonArray translationArray = json["auto_translation"].toArray();
+        if (translationArray.isEmpty()) {
+            qWarning() << "No translations in response";
+            return false;
+        }
+
+        for(const QJsonValue &value : translationArray) {
+            if (!value.isString()) continue;
+            results->append(value.toString());
+        }
+        break;
+    }
+    default:
+        qWarning() << "Unknown API version";
+        return false;
+    }
+
+    return true;
+}
+
+void Translator::watchResponse(API_VERSION version, ResponseDecoder *decoder)
+{
+    switch (version) {
+    case API_VERSION::V1:
+        decoder->watchArray("translations[]");
+        decoder->watchValue("base_resp.status_code");
+        decoder->watchValue("base_resp.status_message");
+        // 旧的响应格式
+        decoder->watchArray("data.translated_text_list[]");
+        decoder->watchValue("code");
+        decoder->watchValue("message");
+        break;
+    case API_VERSION::V2:
+        decoder->watchArray("auto_translation[]");
+        decoder->watchValue("header.ret_code");
+        break;
+    }
+}
+
+bool Translator::decodeResponse(API_VERSION version, const ResponseDecoder &decoder, QStringList *results)
+{
+    if (decoder.hasError() || !decoder.isComplete()) {
+        qWarning() << "Incomplete or malformed response from server";
+        return false;
+    }
+
+    switch (version) {
+    case API_VERSION::V1: {
+        QStringList translations;
+        if (decoder.contains("translations[]")) {
+            const int code = decoder.value("base_resp.status_code").toInt();
+            if (code != 0) {
+                qWarning() << "Translation failed, error code:" << code
+                          << "message:" << decoder.value("base_resp.status_message");
+                return false;
+            }
+            translations = decoder.array("translations[]");
+        } else if (decoder.contains("code")) {
+            const int code = decoder.value("code").toInt();
+            if (code != 0) {
+                qWarning() << "Translation failed, error code:" << code
+                          << "message:" << decoder.value("message");
+                return false;
+            }
+            translations = decoder.array("data.translated_text_list[]");
+        } else {
+            qWarning() << "Unknown V1 API response format";
+            return false;
+        }
+
+        if (translations.isEmpty()) {
+            qWarning() << "No translations in response";
+            return false;
+        }
+        *results = translations;
+        break;
+    }
+    case API_VERSION::V2: {
+        const QString retCode = decoder.value("header.ret_code");
+        if (retCode != "succ") {
+            qWarning() << "Translation failed, error code:" << retCode;
+            return false;
+        }
+
+        const QStringList translations = decoder.array("auto_translation[]");
+        if (translations.isEmpty()) {
+            qWarning() << "No translations in response";
+            return false;
+        }
+        *results = translations;
+        break;
+    }
+    default:
+        qWarning() << "Unknown API version";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,241 @@
+#ifndef TRANSLATOR_H
+#define TRANSLATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QList>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <functional>
+#include "httpmanager.h"
+#include "latencytracer.h"
+#include "providerstats.h"
+#include "responsedecoder.h"
+#include "textsegmenter.h"
+#include "translationcache.h"
+#include "translationstore.h"
+
+enum API_VERSION{
+    V1,
+    V2
+};
+
+// 翻译引擎：把文本切分成批次，并发发送给翻译服务，按顺序给出每个批次的结果。
+// 每次 translate 对应一个任务（job），结果通过 sig_chunkFinished 逐块返回。
+class Translator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Translator(QObject *parent = nullptr);
+
+    // --encode-bench：比较 QJsonObject 和请求模板构建两家服务商请求体的耗时与分配次数
+    static bool isBenchMode(int argc, char *argv[]);
+    static int benchmark(const QStringList &arguments);
+
+    void setApiVersion(API_VERSION version) { m_apiVersion = version; }
+    API_VERSION apiVersion() const { return m_apiVersion; }
+    void setMaxInFlight(int maxInFlight) { m_maxInFlight = qMax(1, maxInFlight); }
+    void setChunkSize(int chunkSize) { m_chunkSize = qMax(100, chunkSize); }
+    // 对冲模式：主服务商超过其 p90 延迟仍未返回时，同时向另一服务商发送，先到先用
+    void setHedging(bool enabled) { m_hedging = enabled; }
+    // 自动选择当前最快的健康服务商作为主服务商，关闭时固定使用 apiVersion
+    void setAutoSelect(bool enabled) { m_autoSelect = enabled; }
+    bool openStore(const QString &path) { return m_store.open(path); }
+    // 请求体序列化和响应解析放到线程池执行，关闭时在 GUI 线程上同步执行
+    void setPipelineEnabled(bool enabled) { m_pipeline = enabled; }
+    // 流式解码：响应数据到达时即增量解析，只提取译文和错误码，不构建 JSON DOM；
+    // 关闭时等响应完整后用 QJsonDocument 解析
+    void setStreamingDecoder(bool enabled);
+    // 修复从 PDF 复制的文本中被拆开的单词和句中换行
+    void setRepairLineBreaks(bool enabled) { m_repairLineBreaks = enabled; }
+    // 识别 HTML、Markdown 和源代码，只发送自然语言部分，标签、网址和代码原样拼回
+    void setMarkupAware(bool enabled) { m_markupAware = enabled; }
+    // 覆盖服务商接口的协议、主机和端口（如 http://127.0.0.1:8080），路径不变；
+    // 用于指向本地模拟服务，传空字符串恢复默认地址
+    void setBaseUrl(API_VERSION version, const QString &baseUrl);
+    QString providerUrl(API_VERSION version) const;
+    // 交互任务的首个批次和对冲请求优先发出，其余批次按批量请求排队；设为 Bulk 时全部按批量处理
+    void setPriority(HttpManager::Priority priority) { m_priority = priority; }
+    // 服务商的每秒请求数上限（0 表示不限）和每个主机同时进行的请求数
+    void setRateLimit(API_VERSION version, double requestsPerSecond);
+    void setMaxInFlightPerHost(int maxInFlight) { http.setMaxInFlightPerHost(maxInFlight); }
+    // 与服务商协商 HTTP/2，并发批次和对冲请求复用同一连接；maxStreams 为每个主机同时进行的流数
+    void setHttp2Enabled(bool enabled) { http.setHttp2Enabled(enabled); }
+    void setMaxStreamsPerHost(int maxStreams) { http.setMaxStreamsPerHost(maxStreams); }
+    void setHttp2Cleartext(bool enabled) { http.setHttp2Cleartext(enabled); }
+    // 响应按 gzip/deflate/br 压缩传输；请求体压缩只对明确接受压缩请求的服务商开启
+    void setResponseCompression(bool enabled) { http.setResponseCompression(enabled); }
+    void setRequestCompression(API_VERSION version, bool enabled);
+
+    // 创建任务但不发送，便于调用方在结果返回前记录任务 ID；
+    // traceId 为 tracer().begin() 返回的跟踪，翻译过程中的各阶段会记录到其中
+    quint64 createJob(const QString &source, quint64 traceId = 0);
+    void start(quint64 jobId);
+    void cancel(quint64 jobId);
+    int chunkCount(quint64 jobId) const;
+
+    // 预先连接到会用到的服务商，省去首次翻译的握手时间
+    void preconnect();
+    void setKeepAlive(int intervalMs, int idleTimeoutMs) { http.setKeepAlive(intervalMs, idleTimeoutMs); }
+    QStringList connectionSummary() const { return http.connectionSummary(); }
+    QStringList queueSummary() const { return http.queueSummary(); }
+    QStringList transferSummary() const { return http.transferSummary(); }
+    void setSessionCacheFile(const QString &path) { http.setSessionCacheFile(path); }
+
+    const TranslationCache &cache() const { return m_cache; }
+    // 端到端耗时跟踪，调用方负责在结果显示后 finish
+    LatencyTracer &tracer() { return m_tracer; }
+    ProviderStats stats(API_VERSION version) const { return m_stats.value(version); }
+    API_VERSION selectProvider() const;
+
+    // 请求体构建和响应解析的开销统计
+    struct CodecStats {
+        quint64 count{0};
+        quint64 bytes{0};
+        qint64 nsecs{0};
+    };
+    CodecStats encodeStats() const { return m_encodeStats; }
+    CodecStats decodeStats() const { return m_decodeStats; }
+    QString encodeSummary() const;
+    QString decodeSummary() const;
+
+    // 句子级复用统计：复用的句子省去的发送量，以及整批命中省去的请求往返
+    struct ReuseStats {
+        quint64 reusedSegments{0};
+        quint64 reusedBytes{0};
+        quint64 sentSegments{0};
+        quint64 sentBytes{0};     // 实际发送的请求体大小
+        double savedMs{0};
+    };
+    ReuseStats reuseStats() const { return m_reuseStats; }
+    QString reuseSummary() const;
+
+    // 请求体精简统计：原文大小与去重、跳过无需翻译的片段和标记、合并空白后实际发送的文本大小
+    struct PayloadStats {
+        quint64 sourceBytes{0};
+        quint64 sentTextBytes{0};
+        quint64 duplicateSegments{0};
+        quint64 trivialSegments{0};
+        quint64 verbatimBytes{0};     // 原样保留、未发送的标签和代码
+    };
+    PayloadStats payloadStats() const { return m_payloadStats; }
+    QString payloadSummary() const;
+
+    static QString providerName(API_VERSION version);
+    static API_VERSION otherProvider(API_VERSION version);
+
+signals:
+    void sig_chunkFinished(quint64 jobId, int index, QString text);
+    void sig_jobFinished(quint64 jobId, bool ok);
+
+private slots:
+    void dataReceived(quint64 requestId, QByteArray data, bool first);
+    void finished(quint64 requestId, QByteArray data, HttpManager::RequestStatus status);
+
+private:
+    struct Chunk {
+        QList<TextSegment> units;   // 句子，缓存和发送都以句子为单位
+        QStringList results;        // 各句译文，尚未得到时为空
+        QList<int> missing;         // 缓存未命中、需要发送的句子序号
+        QStringList texts;          // 实际发送的文本，重复的句子只出现一次
+        QList<int> textIndex;       // missing 中每个句子对应 texts 的下标
+        QList<quint64> requestIds;  // 进行中的请求，对冲时可能有两个
+        int single{-1};             // 译文数量与句子对不上后改为逐句重发，当前发送的 texts 下标
+        QStringList singleResults;  // 逐句重发得到的译文
+        int pending{0};             // 尚未结束的尝试（构建请求体、请求中、解析中）
+        bool hedged{false};
+        bool done{false};
+    };
+
+    struct Job {
+        API_VERSION apiVersion{API_VERSION::V1};  // 主服务商
+        QString language;  // 检测到的源语言，为空时交给服务商识别
+        quint64 traceId{0};
+        QList<Chunk> chunks;
+        int nextChunk{0};
+        int inFlight{0};
+        int remaining{0};
+        bool failed{false};
+    };
+
+    // 流式模式下一个请求的解码状态，只在解码线程上读写
+    struct StreamDecode {
+        ResponseDecoder decoder;
+        qint64 nsecs{0};
+        qint64 bytes{0};
+    };
+
+    struct Request {
+        quint64 jobId{0};
+        int index{0};
+        API_VERSION apiVersion{API_VERSION::V1};  // 实际发送的服务商
+        int single{-1};  // 逐句重发时对应的 texts 下标，整批发送时为 -1
+        QElapsedTimer elapsed;
+        qint64 latencyMs{0};  // 发出到响应结束的耗时，不含之后排队解析的时间
+    };
+
+    void pump(quint64 jobId);
+    void runTask(const std::function<void()> &task);
+    void runDecodeTask(const std::function<void()> &task);
+    void sendChunk(quint64 jobId, int index, API_VERSION version);
+    void dispatchChunk(quint64 jobId, int index, API_VERSION version, int single, const QByteArray &body);
+    void chunkParsed(const Request &request, HttpManager::RequestStatus status, bool ok, const QStringList &results);
+    void attemptFailed(quint64 jobId, int index);
+    void staleAttempt(quint64 jobId, int index);
+    void hedge(quint64 jobId, int index);
+    void finishChunk(quint64 jobId, int index, bool ok);
+    bool lookupCached(const QList<API_VERSION> &providers, const QString &language, const QString &text, QString *result);
+    void dropRequest(quint64 requestId);
+    void abortAttempts(Chunk *chunk);
+    void markStage(quint64 jobId, LatencyTracer::Stage stage);
+    void recordResult(API_VERSION version, HttpManager::RequestStatus status, bool ok, qint64 ms);
+    int hedgeDelay(API_VERSION version) const;
+    static QString defaultProviderUrl(API_VERSION version);
+    static void languages(API_VERSION version, const QString &language, QString *sourceLang, QString *targetLang);
+    QString cacheKey(API_VERSION version, const QString &language, const QString &text) const;
+    static QByteArray Translation_v1(const QStringList &texts, const QString &sourceLang, const QString &targetLang);
+    static QByteArray Translation_v2(const QStringList &texts, const QString &sourceLang, const QString &targetLang);
+    static QMap<QString, QString> requestHeaders(API_VERSION version);
+    static QString codecSummary(const QString &label, const CodecStats &stats);
+    QNetworkRequest preparedRequest(API_VERSION version);
+    static bool parseResponse(API_VERSION version, const QByteArray &data, QStringList *results);
+    static void watchResponse(API_VERSION version, ResponseDecoder *decoder);
+    static bool decodeResponse(API_VERSION version, const ResponseDecoder &decoder, QStringList *results);
+    static qsizetype utf8Length(QStringView text);
+
+    HttpManager http;
+    API_VERSION m_apiVersion = API_VERSION::V1;
+    int m_maxInFlight{4};     // 单个任务同时进行的请求数上限
+    int m_chunkSize{2000};    // 单个批次的最大字符数
+    bool m_hedging{true};
+    bool m_autoSelect{true};
+    bool m_pipeline{true};
+    bool m_streamingDecoder{true};
+    CodecStats m_encodeStats;
+    CodecStats m_decodeStats;
+    ReuseStats m_reuseStats;
+    PayloadStats m_payloadStats;
+    LatencyTracer m_tracer;
+    bool m_repairLineBreaks{true};
+    bool m_markupAware{true};
+    QHash<int, ProviderStats> m_stats;  // 各服务商的运行统计
+    QHash<int, QString> m_providerUrls;  // 覆盖后的接口地址
+    QHash<int, QNetworkRequest> m_preparedRequests;  // 各服务商预先构建的请求
+    QHash<int, double> m_rateLimits;     // 各服务商的每秒请求数上限
+    QHash<int, bool> m_compressRequests; // 各服务商是否压缩请求体
+    HttpManager::Priority m_priority{HttpManager::Interactive};
+
+    // 翻译结果缓存，命中时不再发起网络请求
+    TranslationCache m_cache;
+    TranslationStore m_store;  // 重启后仍然有效的持久化记录
+
+    quint64 m_nextJobId{1};
+    QHash<quint64, Job> m_jobs;
+    QHash<quint64, Request> m_requests;
+    QHash<quint64, QSharedPointer<StreamDecode>> m_decoders;  // 流式模式下各请求的解码状态
+    QThreadPool m_decodePool;  // 流式解码线程，只有一个线程，保证同一响应的数据按到达顺序输入
+};
+
+#endif // TRANSLATOR_H
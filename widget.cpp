@@ -1,15 +1,12 @@
 #include "widget.h"
 #include "./ui_widget.h"
 #include <QApplication>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonDocument>
 #include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+#include <QTextCursor>
 #include <QTimer>
 
-// 初始化静态成员
-Widget* Widget::s_instance = nullptr;
-
 bool Widget::eventFilter(QObject *watched, QEvent *event)
 {
     if(watched == this){
@@ -28,18 +25,55 @@ Widget::Widget(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::Widget)
     , clipboard(QApplication::clipboard())
-    , m_lastCtrlCPressTime(0)
-    , m_ctrlPress(false)
-    , m_keyboardHook(nullptr)
 {
     if (!clipboard) {
         qWarning() << "Failed to get clipboard instance";
     }
     
     ui->setupUi(this);    
-    s_instance = this;    
+    ui->txt_target->setUndoRedoEnabled(false);  // 只读面板，不保留撤销记录
     installEventFilter(this);
-    connect(&http, &HttpManager::sig_finished, this, &Widget::finished);
+    connect(&m_translator, &Translator::sig_chunkFinished, this, &Widget::chunkFinished);
+    connect(&m_translator, &Translator::sig_jobFinished, this, &Widget::jobFinished);
+
+    // 并发请求数和批次大小可通过配置文件调整
+    QSettings settings(QSettings::IniFormat, QSettings::UserScope, "Translate", "Translate");
+    m_translator.setMaxInFlight(settings.value("translate/maxInFlight", 4).toInt());
+    m_translator.setChunkSize(settings.value("translate/chunkSize", 2000).toInt());
+    m_translator.setHedging(settings.value("translate/hedging", true).toBool());
+    m_translator.setPipelineEnabled(settings.value("translate/pipeline", true).toBool());
+    m_translator.setStreamingDecoder(settings.value("translate/streamingDecoder", true).toBool());
+    m_translator.setRepairLineBreaks(settings.value("translate/repairLineBreaks", true).toBool());
+    m_translator.setMarkupAware(settings.value("translate/markupAware", true).toBool());
+    m_translator.setAutoSelect(settings.value("translate/autoSelect", true).toBool());
+    m_translator.setBaseUrl(API_VERSION::V1, settings.value("providers/volcengineBaseUrl").toString());
+    m_translator.setBaseUrl(API_VERSION::V2, settings.value("providers/tencentBaseUrl").toString());
+    m_translator.setKeepAlive(settings.value("network/keepAliveInterval", 60 * 1000).toInt(),
+                              settings.value("network/idleTimeout", 10 * 60 * 1000).toInt());
+    m_translator.setMaxInFlightPerHost(settings.value("network/maxInFlightPerHost", 6).toInt());
+    m_translator.setHttp2Enabled(settings.value("network/http2", true).toBool());
+    m_translator.setMaxStreamsPerHost(settings.value("network/maxStreamsPerHost", 100).toInt());
+    m_translator.setResponseCompression(settings.value("network/compressResponses", true).toBool());
+    m_translator.setRequestCompression(API_VERSION::V1, settings.value("providers/volcengineCompressRequests", false).toBool());
+    m_translator.setRequestCompression(API_VERSION::V2, settings.value("providers/tencentCompressRequests", false).toBool());
+    m_translator.setRateLimit(API_VERSION::V1, settings.value("providers/volcengineRate", 0).toDouble());
+    m_translator.setRateLimit(API_VERSION::V2, settings.value("providers/tencentRate", 0).toDouble());
+
+    // 离线词典由 --build-dictionary 生成，文件不存在时所有查询都走网络
+    m_dictionary.open(settings.value("dictionary/path", OfflineDictionary::defaultPath()).toString());
+    m_dictionaryRefine = settings.value("dictionary/refine", true).toBool();
+
+    // 实时翻译：输入停顿 debounce 毫秒后翻译，每秒最多 maxRequestsPerSecond 次
+    m_liveTimer = new QTimer(this);
+    m_liveTimer->setSingleShot(true);
+    m_liveTimer->setInterval(qMax(0, settings.value("live/debounce", 400).toInt()));
+    m_liveInterval = 1000 / qMax(1, settings.value("live/maxRequestsPerSecond", 2).toInt());
+    connect(m_liveTimer, &QTimer::timeout, this, &Widget::liveTranslate);
+    connect(ui->txt_source, &QTextEdit::textChanged, this, &Widget::sourceChanged);
+
+    // 打开持久化翻译记录和 TLS 会话缓存
+    m_translator.openStore(TranslationStore::defaultPath());
+    m_translator.setSessionCacheFile(QFileInfo(TranslationStore::defaultPath()).absolutePath() + "/tls_sessions.dat");
     
     // 设置窗口属性
     setWindowFlags(Qt::Window | Qt::Tool | Qt::WindowStaysOnTopHint);
@@ -135,6 +169,12 @@ Widget::Widget(QWidget *parent)
     m_titleAnimTimer->setInterval(500);
     connect(m_titleAnimTimer, &QTimer::timeout, this, &Widget::updateTitleAnimation);
 
+    // 批量写入翻译结果的定时器，约一帧刷新一次
+    m_renderTimer = new QTimer(this);
+    m_renderTimer->setSingleShot(true);
+    m_renderTimer->setInterval(16);
+    connect(m_renderTimer, &QTimer::timeout, this, &Widget::flushResults);
+
     // 设置窗口图标
     QIcon icon(":/res/translate.svg");
     setWindowIcon(icon);
@@ -144,9 +184,10 @@ Widget::Widget(QWidget *parent)
     createActions();
     createTrayIcon();
     
-    // 确保在构造函数最后安装钩子
+    // 确保在构造函数最后安装钩子，并预先连接翻译服务
     QTimer::singleShot(0, this, [this]() {
         installHook();
+        warmUp();
     });
 }
 
@@ -155,9 +196,6 @@ Widget::~Widget()
     // 先卸载钩子
     uninstallHook();
     
-    // 确保实例指针在其他清理之前被置空
-    s_instance = nullptr;
-    
     // 如果托盘图标存在，先隐藏它
     if (m_trayIcon) {
         m_trayIcon->hide();
@@ -178,101 +216,187 @@ Widget::~Widget()
     }
 }
 
-LRESULT CALLBACK Widget::KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
+void Widget::installHook()
 {
-    if (nCode >= 0 && s_instance)
-    {
-        KBDLLHOOKSTRUCT* pKeyInfo = (KBDLLHOOKSTRUCT*)lParam;
-        
-        switch (wParam)
-        {
-        case WM_KEYDOWN:
-            
-            // 检测 Ctrl 键
-            if (pKeyInfo->vkCode == VK_LCONTROL || pKeyInfo->vkCode == VK_RCONTROL)
-            {
-                s_instance->m_ctrlPress = true;
-            }
-            // 检测 C 键
-            else if (pKeyInfo->vkCode == 'C')
-            {
-                if (s_instance->m_ctrlPress)
-                {
-                    DWORD currentTime = GetTickCount();
-                    DWORD timeDiff = currentTime - s_instance->m_lastCtrlCPressTime;
-                    
-                    if (timeDiff <= 500)
-                    {
-                        QMetaObject::invokeMethod(s_instance, "keyDownHandle", Qt::QueuedConnection);
-                    }
-                    s_instance->m_lastCtrlCPressTime = currentTime;
-                }
-            }
-            break;
-            
-        case WM_KEYUP:
-            // 检测 Ctrl 键释放
-            if (pKeyInfo->vkCode == VK_LCONTROL || pKeyInfo->vkCode == VK_RCONTROL)
-            {
-                s_instance->m_ctrlPress = false;
-            }
-            break;
-        }
+    if (m_hotkeyMonitor) {
+        return;
     }
-    return CallNextHookEx(NULL, nCode, wParam, lParam);
+#ifdef Q_OS_WIN
+    // 钩子在监听线程的消息循环中运行，检测结果排队送回 GUI 线程
+    m_hotkeyMonitor = new HotkeyMonitor(new WindowsKeyEventSource, this);
+    // 首次按下 Ctrl 时预热连接，等双击 Ctrl+C 时连接已就绪
+    connect(m_hotkeyMonitor, &HotkeyMonitor::sig_ctrlPressed, this, &Widget::warmUp);
+    connect(m_hotkeyMonitor, &HotkeyMonitor::sig_hotkey, this, [this](qint64 time) {
+        m_hotkeyTime = time;
+        keyDownHandle();
+    });
+    m_hotkeyMonitor->start(QThread::TimeCriticalPriority);
+#else
+    qDebug() << "Global hotkey is only supported on Windows";
+#endif
 }
 
-void Widget::installHook()
+void Widget::uninstallHook()
 {
-    m_keyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardProc, GetModuleHandle(NULL), 0);
-    if (m_keyboardHook == NULL)
-    {
-        DWORD error = GetLastError();
-        qDebug() << "Failed to install keyboard hook. Error:" << error;
+    if (m_hotkeyMonitor) {
+        // 退出监听线程的消息循环并卸载钩子
+        m_hotkeyMonitor->stop();
+        delete m_hotkeyMonitor;
+        m_hotkeyMonitor = nullptr;
     }
 }
 
-void Widget::uninstallHook()
+void Widget::Translation(const QString &text, bool live, quint64 traceId)
 {
-    if (m_keyboardHook != NULL) {
-        // 在卸载钩子之前暂停一下，确保没有正在处理的钩子消息
-        Sleep(100);
-        
-        BOOL result = UnhookWindowsHookEx(m_keyboardHook);
-        if (!result) {
-            qDebug() << "Failed to uninstall hook. Error:" << GetLastError();
+    // 取消仍在进行中的旧任务
+    m_translator.cancel(m_currentJobId);
+    m_liveTimer->stop();
+    m_lastSourceText = text;
+
+    // 按钮和实时翻译从这里开始计时，热键触发时由 keyDownHandle 传入
+    m_traceId = traceId ? traceId : m_translator.tracer().begin();
+
+    // 单词或短语命中离线词典时先显示释义，网络译文随后写在释义下方
+    QString entry;
+    m_targetOffset = 0;
+    if (!live && m_dictionary.lookup(text, &entry)) {
+        if (!m_dictionaryRefine) {
+            ui->txt_target->setPlainText(entry);
+            m_translator.tracer().setLabel(m_traceId, "dictionary");
+            m_translator.tracer().mark(m_traceId, LatencyTracer::Rendered);
+            m_currentJobId = 0;
+            m_translator.tracer().finish(m_traceId);
+            stopTitleAnimation();
+            return;
         }
-        m_keyboardHook = NULL;
+        entry += "\n\n";
+        m_targetOffset = entry.size();
+    }
+
+    m_currentJobId = m_translator.createJob(text, m_traceId);
+    const quint64 jobId = m_currentJobId;
+    const int count = m_translator.chunkCount(jobId);
+
+    // 每个批次先放一个占位符，译文返回后只替换对应区域
+    const QString placeholder = count > 1 ? QStringLiteral("…\n") : QString();
+    m_chunkLengths = QList<int>(count, placeholder.size());
+    m_pendingChunks.clear();
+    m_renderTimer->stop();
+    m_firstTextShown = false;
+    m_firstTextClock.start();
+
+    if (!live) {
+        ui->txt_target->setPlainText(entry + placeholder.repeated(count));
+        if (m_targetOffset > 0) {
+            m_translator.tracer().mark(m_traceId, LatencyTracer::Rendered);
+        }
+
+        // 缓存全部命中时 start 内会同步结束任务并停止动画
+        startTitleAnimation();
+        m_translator.start(jobId);
+        return;
+    }
+
+    // 实时模式：未改动的句子在 start 内同步命中缓存，先收集起来，
+    // 再与面板现有内容比较，只替换变化的部分，避免每次输入整篇闪烁
+    m_deferRender = true;
+    m_translator.start(jobId);
+    m_deferRender = false;
+
+    QStringList texts(count, placeholder);
+    const bool rendered = !m_pendingChunks.isEmpty();
+    for (const auto &chunk : std::as_const(m_pendingChunks)) {
+        texts[chunk.first] = chunk.second;
+        texts[chunk.first].replace("\r\n", "\n");
+    }
+    m_pendingChunks.clear();
+    if (count == 1 && m_currentJobId == jobId) {
+        // 只有一个批次且需要请求时保留旧译文，等新结果返回后再替换
+        texts[0] = ui->txt_target->toPlainText();
+    }
+    for (int i = 0; i < count; ++i) {
+        m_chunkLengths[i] = texts.at(i).size();
+    }
+    replaceTarget(texts.join(QString()));
+    if (rendered) {
+        m_translator.tracer().mark(m_traceId, LatencyTracer::Rendered);
+    }
+
+    if (m_currentJobId == jobId) {
+        startTitleAnimation();
+    } else {
+        m_translator.tracer().finish(m_traceId);
     }
 }
 
-void Widget::Translation(QJsonArray textList)
+void Widget::replaceTarget(const QString &text)
 {
-    switch (apiVersion) {
-    case API_VERSION::V1:{
-        this->Translation_v1(textList);
-    }break;
-    case API_VERSION::V2:{
-        this->Translation_v2(textList);
-    }break;
-    default:
-        break;
+    // 只替换新旧内容之间不同的中间部分，保留滚动位置和未变化的排版
+    const QString current = ui->txt_target->toPlainText();
+    const int limit = qMin(current.size(), text.size());
+    int prefix = 0;
+    while (prefix < limit && current.at(prefix) == text.at(prefix)) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < limit - prefix
+           && current.at(current.size() - 1 - suffix) == text.at(text.size() - 1 - suffix)) {
+        ++suffix;
+    }
+    if (prefix == current.size() && prefix == text.size()) {
+        return;
+    }
+
+    QTextCursor cursor(ui->txt_target->document());
+    cursor.beginEditBlock();
+    cursor.setPosition(prefix);
+    cursor.setPosition(current.size() - suffix, QTextCursor::KeepAnchor);
+    cursor.insertText(text.mid(prefix, text.size() - prefix - suffix));
+    cursor.endEditBlock();
+}
+
+void Widget::sourceChanged()
+{
+    if (!m_liveAction || !m_liveAction->isChecked()) {
+        return;
+    }
+    // 每次输入都重新计时，停顿后才翻译
+    m_liveTimer->start();
+}
+
+void Widget::liveTranslate()
+{
+    // 距上次实时请求不足最小间隔时推迟到间隔结束
+    if (m_liveClock.isValid() && m_liveClock.elapsed() < m_liveInterval) {
+        m_liveTimer->start(m_liveInterval - int(m_liveClock.elapsed()));
+        return;
     }
+
+    const QString text = ui->txt_source->toPlainText().trimmed();
+    if (text.isEmpty() || text == m_lastSourceText) {
+        return;
+    }
+    m_liveClock.start();
+    Translation(text, true);
 }
 
 void Widget::keyDownHandle()
 {
+    // 从钩子识别到热键开始计时
+    LatencyTracer &tracer = m_translator.tracer();
+    const quint64 traceId = tracer.begin(m_hotkeyTime);
+    m_hotkeyTime = 0;
+    tracer.mark(traceId, LatencyTracer::KeyHandled);
+
     QString data = getClipboardContent();
     if(data.isEmpty()){
         qDebug() << "Clipboard is empty";
+        tracer.discard(traceId);
         return;
     }
+    tracer.mark(traceId, LatencyTracer::Clipboard);
     
     data = data.trimmed();
-    if (data.length() > 5000) {
-        qWarning() << "Text too long, truncating to 5000 characters";
-        data = data.left(5000);
-    }
     
     ui->txt_source->setTextColor(QColor(97, 97, 97));
     ui->txt_source->clear();
@@ -280,9 +404,15 @@ void Widget::keyDownHandle()
     
     // 先显示窗口
     showAndActivateWindow();
+    tracer.mark(traceId, LatencyTracer::WindowShown);
     
-    // 使用 Translation 函数，它会根据 apiVersion 选择正确的 API
-    Translation(QJsonArray{data});
+    // 长文本由 Translator 切分为多个批次并发翻译
+    Translation(data, false, traceId);
+}
+
+void Widget::warmUp()
+{
+    m_translator.preconnect();
 }
 
 void Widget::showAndActivateWindow()
@@ -316,212 +446,71 @@ void Widget::showAndActivateWindow()
     raise();
 }
 
-bool Widget::isChineseText(const QString& text) {
-    for (const QChar& ch : text) {
-        if (ch.unicode() >= 0x4E00 && ch.unicode() <= 0x9FFF) {
-            return true;
-        }
-    }
-    return false;
-}
-
-void Widget::Translation_v1(QJsonArray textList)
+void Widget::chunkFinished(quint64 jobId, int index, QString text)
 {
-    if (textList.isEmpty()) {
-        qWarning() << "Empty text list for translation";
+    // 忽略已被新任务取代的旧结果
+    if (jobId != m_currentJobId || index < 0 || index >= m_chunkLengths.size()) {
         return;
     }
 
-    // 清空翻译结果
-    ui->txt_target->clear();
-    
-    startTitleAnimation();
-
-    // 获取源文本并按行分割
-    QString sourceText = textList[0].toString();
-    QStringList lines = sourceText.split('\n');
-
-    // 创建新的文本列表，保留空行
-    QJsonArray lineArray;
-    for (const QString& line : lines) {
-        lineArray.append(line);  // 不过滤空行，保持原格式
+    // 短时间内返回的多个批次合并为一次写入
+    m_pendingChunks.append(qMakePair(index, text));
+    if (!m_renderTimer->isActive()) {
+        m_renderTimer->start();
     }
-
-    // 创建请求体
-    QJsonObject json;
-    json["source_language"] = "detect";
-    json["target_language"] = isChineseText(sourceText) ? "en" : "zh";
-    json["text_list"] = lineArray;  // 使用按行分割后的数组
-    json["glossary_list"] = QJsonArray();
-    json["enable_user_glossary"] = false;
-    json["category"] = "";
-
-    QMap<QString, QString> headers;
-    headers["User-Agent"] = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/131.0.0.0 Safari/537.36";
-    headers["content-type"] = "application/json";
-
-    http.sendPostRequest("https://translate.volcengine.com/crx/translate/v2/", json, headers);
 }
 
-
-void Widget::Translation_v2(QJsonArray textList)
+void Widget::jobFinished(quint64 jobId, bool ok)
 {
-    if (textList.isEmpty()) {
-        qWarning() << "Empty text list for translation";
+    if (jobId != m_currentJobId) {
         return;
     }
+    m_currentJobId = 0;
 
-    // 清空翻译结果
-    ui->txt_target->clear();
-    
-    startTitleAnimation();
-
-    // 自动检测源文本语言并设置目标语言
-    QString sourceText = textList[0].toString();
-    QString targetLang = isChineseText(sourceText) ? "en" : "zh";
-    QString sourceLang = isChineseText(sourceText) ? "zh" : "en";
-
-    QJsonObject source;
-    source["lang"] = sourceLang;
-    source["text_list"] = textList;
-
-    QJsonObject target;
-    target["lang"] = targetLang;
-
-    QJsonObject header;
-    header["fn"] = "auto_translation";
-    header["session"] = "";
-    header["client_key"] = "browser-chrome-131.0.0";
-    header["user"] = "";
-
-    QJsonObject json;
-    json["header"] = header;
-    json["type"] = "plain";
-    json["model_category"] = "normal";
-    json["text_domain"] = "general";
-    json["source"] = source;
-    json["target"] = target;
-
-    QMap<QString, QString> headers;
-    headers["User-Agent"] = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/131.0.0.0 Safari/537.36";
-    headers["content-type"] = "application/json";
-    headers["Accept"] = "application/json, text/plain, */*";
-    headers["Origin"] = "https://yi.qq.com";
-    headers["Referer"] = "https://yi.qq.com/";
-
-    http.sendPostRequest("https://yi.qq.com/api/imt", json, headers);
-}
-
-void Widget::finished(QByteArray data)
-{
+    // 任务结束时立即写入剩余结果，缓存命中时同步显示
+    flushResults();
+    // 实时模式下同步结束的任务在写入面板后由 Translation 结束跟踪
+    if (!m_deferRender) {
+        m_translator.tracer().finish(m_traceId);
+    }
     stopTitleAnimation();
-
-    if (data.isEmpty()) {
-        qWarning() << "Received empty response from server";
-        return;
+    if (!ok) {
+        qWarning() << "Some chunks failed to translate";
     }
+    ui->txt_source->setTextColor(QColor(46, 47, 48));
+}
 
-    QJsonParseError parseError;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &parseError);
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << parseError.errorString();
+void Widget::flushResults()
+{
+    m_renderTimer->stop();
+    if (m_deferRender || m_pendingChunks.isEmpty()) {
         return;
     }
 
-    QJsonObject json = jsonDoc.object();
-    QString result;
-
-    // qDebug() << "API Version:" << this->apiVersion;
-    // qDebug() << "Response data:" << QString(data);
-
-    switch (apiVersion) {
-    case API_VERSION::V1: {
-        // 处理火山翻译 API 响应
-        // 检查新的响应格式
-        if (json.contains("translations")) {
-            QJsonObject baseResp = json["base_resp"].toObject();
-            if (baseResp["status_code"].toInt() != 0) {
-                qWarning() << "Translation failed, error code:" << baseResp["status_code"].toInt()
-                          << "message:" << baseResp["status_message"].toString();
-                return;
-            }
-
-            QJsonArray translations = json["translations"].toArray();
-            if (translations.isEmpty()) {
-                qWarning() << "No translations in response";
-                qDebug() << "Full response object:" << json;
-                return;
-            }
-
-            for (const QJsonValue &value : translations) {
-                if (!value.isString()) continue;
-                if (!result.isEmpty()) {
-                    result.append("\n");
-                }
-                result.append(value.toString());
-            }
+    // 只替换对应批次的占位区域，在一个编辑块内完成，避免整篇文档重新排版
+    QTextCursor cursor(ui->txt_target->document());
+    cursor.beginEditBlock();
+    for (const auto &chunk : std::as_const(m_pendingChunks)) {
+        int position = m_targetOffset;
+        for (int i = 0; i < chunk.first; ++i) {
+            position += m_chunkLengths.at(i);
         }
-        // 兼容旧的响应格式
-        else if (json.contains("code")) {
-            int code = json["code"].toInt();
-            if (code != 0) {
-                qWarning() << "Translation failed, error code:" << code 
-                          << "message:" << json["message"].toString();
-                return;
-            }
-
-            QJsonObject data = json["data"].toObject();
-            QJsonArray translatedTextList = data["translated_text_list"].toArray();
-            
-            if (translatedTextList.isEmpty()) {
-                qWarning() << "No translations in response";
-                qDebug() << "Full response object:" << json;
-                return;
-            }
 
-            for (const QJsonValue &value : translatedTextList) {
-                if (!value.isString()) continue;
-                if (!result.isEmpty()) {
-                    result.append("\n");
-                }
-                result.append(value.toString());
-            }
-        }
-        else {
-            qWarning() << "Unknown V1 API response format";
-            qDebug() << "Full response object:" << json;
-            return;
-        }
-        break;
+        QString text = chunk.second;
+        text.replace("\r\n", "\n");
+        cursor.setPosition(position);
+        cursor.setPosition(position + m_chunkLengths.at(chunk.first), QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+        m_chunkLengths[chunk.first] = text.size();
     }
-    case API_VERSION::V2: {
-        // 处理腾讯翻译 API 响应
-        QJsonObject header = json["header"].toObject();
-        if (header["ret_code"].toString() != "succ") {
-            qWarning() << "Translation failed, error code:" << header["ret_code"].toString();
-            return;
-        }
-
-        QJsonArray translationArray = json["auto_translation"].toArray();
-        if (translationArray.isEmpty()) {
-            qWarning() << "No translations in response";
-            return;
-        }
+    cursor.endEditBlock();
+    m_pendingChunks.clear();
 
-        for(const QJsonValue &value : translationArray) {
-            if (!value.isString()) continue;
-            result.append(value.toString());
-        }
-        break;
-    }
-    default:
-        qWarning() << "Unknown API version";
-        return;
+    if (!m_firstTextShown) {
+        m_firstTextShown = true;
+        m_translator.tracer().mark(m_traceId, LatencyTracer::Rendered);
+        qDebug() << "Time to first visible text:" << m_firstTextClock.elapsed() << "ms";
     }
-
-    ui->txt_target->clear();
-    ui->txt_target->append(result);
-    ui->txt_source->setTextColor(QColor(46, 47, 48));
 }
 
 QString Widget::getClipboardContent()
@@ -539,13 +528,22 @@ void Widget::on_btn_translate_clicked()
     if(data.isEmpty()){
         return;
     }
-    Translation(QJsonArray{data});
+    Translation(data);
 }
 
 void Widget::createActions()
 {
     m_quitAction = new QAction(tr("退出"), this);
     connect(m_quitAction, &QAction::triggered, qApp, &QApplication::quit);
+
+    // 实时翻译开关，保存到配置文件
+    m_liveAction = new QAction(tr("实时翻译"), this);
+    m_liveAction->setCheckable(true);
+    m_liveAction->setChecked(QSettings(QSettings::IniFormat, QSettings::UserScope, "Translate", "Translate")
+                                 .value("live/enabled", false).toBool());
+    connect(m_liveAction, &QAction::toggled, this, [](bool checked) {
+        QSettings(QSettings::IniFormat, QSettings::UserScope, "Translate", "Translate").setValue("live/enabled", checked);
+    });
 }
 
 void Widget::createTrayIcon()
@@ -569,6 +567,10 @@ void Widget::createTrayIcon()
         }
     )");
     
+    m_statsMenu = m_trayIconMenu->addMenu(tr("服务状态"));
+    connect(m_statsMenu, &QMenu::aboutToShow, this, &Widget::updateStatsMenu);
+    m_trayIconMenu->addAction(m_liveAction);
+    m_trayIconMenu->addSeparator();
     m_trayIconMenu->addAction(m_quitAction);
 
     m_trayIcon = new QSystemTrayIcon(this);
@@ -590,6 +592,69 @@ void Widget::createTrayIcon()
     });
 }
 
+void Widget::updateStatsMenu()
+{
+    // 每次展开时刷新统计信息
+    m_statsMenu->clear();
+    const API_VERSION current = m_translator.selectProvider();
+    for (API_VERSION version : {API_VERSION::V1, API_VERSION::V2}) {
+        const ProviderStats stats = m_translator.stats(version);
+        QString text = Translator::providerName(version);
+        if (version == current) {
+            text += tr("（当前）");
+        }
+        if (!stats.isHealthy()) {
+            text += tr("（不可用）");
+        }
+        text += "  " + stats.summary();
+        m_statsMenu->addAction(text)->setEnabled(false);
+    }
+
+    const QStringList connections = m_translator.connectionSummary() + m_translator.queueSummary()
+                                     + m_translator.transferSummary();
+    if (!connections.isEmpty()) {
+        m_statsMenu->addSeparator();
+        for (const QString &line : connections) {
+            m_statsMenu->addAction(line)->setEnabled(false);
+        }
+    }
+
+    const TranslationCache &cache = m_translator.cache();
+    m_statsMenu->addSeparator();
+    m_statsMenu->addAction(tr("缓存 命中 %1  未命中 %2  %3 KB")
+                               .arg(cache.hits())
+                               .arg(cache.misses())
+                               .arg(cache.bytes() / 1024))->setEnabled(false);
+    m_statsMenu->addAction(m_translator.payloadSummary())->setEnabled(false);
+    m_statsMenu->addAction(m_translator.reuseSummary())->setEnabled(false);
+    m_statsMenu->addAction(m_translator.encodeSummary())->setEnabled(false);
+    m_statsMenu->addAction(m_translator.decodeSummary())->setEnabled(false);
+    if (m_dictionary.isOpen()) {
+        m_statsMenu->addAction(m_dictionary.summary())->setEnabled(false);
+    }
+
+    const QStringList latency = m_translator.tracer().summary();
+    if (!latency.isEmpty()) {
+        m_statsMenu->addSeparator();
+        for (const QString &line : latency) {
+            m_statsMenu->addAction(line)->setEnabled(false);
+        }
+    }
+    m_statsMenu->addSeparator();
+    m_statsMenu->addAction(tr("导出耗时跟踪"), this, &Widget::exportTrace);
+}
+
+void Widget::exportTrace()
+{
+    // 写到翻译记录所在目录：trace.json 可在 chrome://tracing 或 Perfetto 中打开，
+    // metrics.prom 为 Prometheus 文本格式
+    const QString dir = QFileInfo(TranslationStore::defaultPath()).absolutePath();
+    const LatencyTracer &tracer = m_translator.tracer();
+    const bool ok = tracer.writeChromeTrace(dir + "/trace.json") && tracer.writeMetrics(dir + "/metrics.prom");
+    m_trayIcon->showMessage(tr("耗时跟踪"), ok ? tr("已导出到 %1").arg(dir) : tr("导出失败"),
+                            ok ? QSystemTrayIcon::Information : QSystemTrayIcon::Warning);
+}
+
 // 添加标题栏动画相关函数实现
 void Widget::startTitleAnimation()
 {
@@ -3,18 +3,17 @@
 
 #include <QWidget>
 #include <QClipboard>
-#include <QJsonArray>
 #include <QEvent>
+#ifdef Q_OS_WIN
 #include <windows.h>
+#endif
 #include <QSystemTrayIcon>
 #include <QMenu>
-#include "httpmanager.h"
+#include "translator.h"
+#include "hotkeymonitor.h"
+#include "offlinedictionary.h"
 #include <QTimer>
-
-enum API_VERSION{
-    V1,
-    V2
-};
+#include <QElapsedTimer>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class Widget; }
@@ -34,21 +33,25 @@ protected:
 
 private slots:
     void on_btn_translate_clicked();
-    void finished(QByteArray data);
+    void chunkFinished(quint64 jobId, int index, QString text);
+    void jobFinished(quint64 jobId, bool ok);
     void keyDownHandle();
+    void warmUp();
+    void sourceChanged();
+    void liveTranslate();
 
 private:
     void installHook();
     void uninstallHook();
-    void Translation(QJsonArray textList);
-    void Translation_v1(QJsonArray textList);
-    void Translation_v2(QJsonArray textList);
+    void Translation(const QString &text, bool live = false, quint64 traceId = 0);
+    void replaceTarget(const QString &text);
     QString getClipboardContent();
-    static LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
     void showAndActivateWindow();
-    bool isChineseText(const QString& text);
+    void flushResults();
     void createTrayIcon();
     void createActions();
+    void updateStatsMenu();
+    void exportTrace();
 
     // 标题栏动画相关
     void startTitleAnimation();
@@ -57,26 +60,43 @@ private:
 
 private:
     Ui::Widget *ui;
-    HttpManager http;
+    Translator m_translator;
     QClipboard *clipboard{nullptr};
-    API_VERSION apiVersion = API_VERSION::V1;
+
+    // 当前交互任务，新的翻译会取消旧任务，只渲染最新结果
+    quint64 m_currentJobId{0};
+    OfflineDictionary m_dictionary;  // 单词和短语先查离线词典，立即显示
+    bool m_dictionaryRefine{true};   // 查到词条后是否继续请求网络翻译
+    int m_targetOffset{0};           // 结果面板中词条释义占用的字符数，译文写在其后
+    QList<int> m_chunkLengths;   // 各批次在结果面板中当前占用的字符数（占位符或译文）
+    QList<QPair<int, QString>> m_pendingChunks;  // 等待批量写入面板的译文
+    QTimer *m_renderTimer{nullptr};
+    QElapsedTimer m_firstTextClock;  // 从发起翻译到首段译文可见的耗时
+    bool m_firstTextShown{false};
+    bool m_deferRender{false};   // 实时模式下先收集同步返回的结果，再一次性写入
+    QString m_lastSourceText;    // 最近一次发起翻译的原文
+    quint64 m_traceId{0};        // 当前任务的耗时跟踪
+    qint64 m_hotkeyTime{0};      // 监听线程识别到热键的时间（LatencyTracer::now）
+
+    // 实时翻译：输入停顿后才发请求，并限制每秒请求数
+    QAction *m_liveAction{nullptr};
+    QTimer *m_liveTimer{nullptr};
+    QElapsedTimer m_liveClock;   // 距上次实时请求的时间
+    int m_liveInterval{500};     // 两次实时请求的最小间隔（毫秒）
 
     // 标题栏动画相关成员
     QTimer* m_titleAnimTimer{nullptr};
     int m_animDots{0};
     QString m_originalTitle;
+
     
-    // 将原来的全局变量转为成员变量
-    DWORD m_lastCtrlCPressTime{0};
-    bool m_ctrlPress{false};
-    HHOOK m_keyboardHook{NULL};
-    
-    // 用于存储当前窗口实例的静态指针
-    static Widget* s_instance;
+    // 全局热键在独立线程上检测，不受 GUI 线程卡顿影响
+    HotkeyMonitor *m_hotkeyMonitor{nullptr};
 
     // 新增：托盘图标相关成员
     QSystemTrayIcon *m_trayIcon{nullptr};
     QMenu *m_trayIconMenu{nullptr};
+    QMenu *m_statsMenu{nullptr};  // 服务商运行统计
     QAction *m_quitAction{nullptr};
 };
 